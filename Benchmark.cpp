@@ -0,0 +1,177 @@
+#include <abel/Benchmark.hpp>
+
+#include <span>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace abel {
+
+// Data written ahead of timed reads, or left behind by timed writes, has to fit into the queue,
+// so the operations are timed in rounds of about this many bytes
+static constexpr size_t round_bytes = 1024 * 1024;
+
+static size_t round_operations(const bench_options &options) {
+    return std::max<size_t>(round_bytes / options.chunk_size, 1);
+}
+
+static void check_options(const bench_options &options) {
+    if (options.chunk_size == 0) {
+        fail("Benchmark chunk size must not be zero");
+    }
+}
+
+// Calls round(count) for rounds of at most per_round operations, first through the warmup and then
+// through the measured operations, and sums up the durations the latter return
+template <typename F>
+static bench_result run_rounds(const bench_options &options, uint64_t per_round, F round) {
+    for (uint64_t done = 0; done < options.warmup;) {
+        uint64_t count = std::min<uint64_t>(per_round, options.warmup - done);
+        round(count);
+        done += count;
+    }
+
+    bench_result result{
+        .operations = options.operations,
+        .bytes = options.operations * options.chunk_size,
+    };
+    for (uint64_t done = 0; done < options.operations;) {
+        uint64_t count = std::min<uint64_t>(per_round, options.operations - done);
+        result.elapsed += round(count);
+        done += count;
+    }
+
+    return result;
+}
+
+bench_result bench_read_full(const bench_options &options) {
+    check_options(options);
+    size_t per_round = round_operations(options);
+
+    auto pair = MemoryStream::create_pair(per_round * options.chunk_size);
+    MemoryStream writer = pair.first;
+    FaultInjecting<MemoryStream> reader{pair.second, options.max_read, 0};
+    std::vector<unsigned char> buf(options.chunk_size);
+
+    return run_rounds(options, per_round, [&](uint64_t count) {
+        for (uint64_t i = 0; i < count; ++i) {
+            writer.write_full_from(buf);
+        }
+
+        auto start = aio_clock::now();
+        for (uint64_t i = 0; i < count; ++i) {
+            reader.read_full_into(buf);
+        }
+        return aio_clock::now() - start;
+    });
+}
+
+static AIO<void> write_async_round(
+    FaultInjecting<MemoryStream> &writer,
+    std::span<const unsigned char> data,
+    uint64_t count,
+    aio_clock::duration &elapsed
+) {
+    auto start = aio_clock::now();
+    for (uint64_t i = 0; i < count; ++i) {
+        co_await writer.write_async_full_from(data);
+    }
+    elapsed = aio_clock::now() - start;
+}
+
+bench_result bench_write_async_full(const bench_options &options) {
+    check_options(options);
+    size_t per_round = round_operations(options);
+
+    auto pair = MemoryStream::create_pair(per_round * options.chunk_size);
+    FaultInjecting<MemoryStream> writer{pair.first, 0, options.max_write};
+    MemoryStream reader = pair.second;
+    std::vector<unsigned char> buf(options.chunk_size);
+
+    return run_rounds(options, per_round, [&](uint64_t count) {
+        aio_clock::duration elapsed{};
+        ParallelAIOs tasks{write_async_round(writer, buf, count, elapsed)};
+        tasks.run();
+
+        for (uint64_t i = 0; i < count; ++i) {
+            reader.read_full_into(buf);
+        }
+        return elapsed;
+    });
+}
+
+static AIO<void> produce(MemoryStream dst, std::span<const unsigned char> data, uint64_t count) {
+    for (uint64_t i = 0; i < count; ++i) {
+        co_await dst.write_async_full_from(data);
+    }
+    dst.shutdown_write();
+}
+
+static AIO<void> consume(MemoryStream src, std::span<unsigned char> data, uint64_t count) {
+    for (uint64_t i = 0; i < count; ++i) {
+        co_await src.read_async_full_into(data);
+    }
+}
+
+bench_result bench_async_transfer(const bench_options &options) {
+    check_options(options);
+    size_t per_round = round_operations(options);
+    size_t capacity = std::max<size_t>(options.chunk_size, 64 * 1024);
+
+    std::vector<unsigned char> out(options.chunk_size);
+    std::vector<unsigned char> in(options.chunk_size);
+
+    return run_rounds(options, per_round, [&](uint64_t count) {
+        // The source gets closed at the end of every round, so each one needs fresh pairs
+        auto source = MemoryStream::create_pair(capacity);
+        auto sink = MemoryStream::create_pair(capacity);
+
+        ParallelAIOs tasks{
+            produce(source.first, out, count),
+            async_transfer(
+                FaultInjecting<MemoryStream>{source.second, options.max_read, 0},
+                FaultInjecting<MemoryStream>{sink.first, 0, options.max_write},
+                options.chunk_size
+            ),
+            consume(sink.second, in, count),
+        };
+
+        auto start = aio_clock::now();
+        tasks.run();
+        return aio_clock::now() - start;
+    });
+}
+
+static AIO<uint64_t> next_value(uint64_t value) {
+    co_return value + 1;
+}
+
+static AIO<void> coroutine_round(uint64_t count, aio_clock::duration &elapsed) {
+    uint64_t value = 0;
+
+    auto start = aio_clock::now();
+    for (uint64_t i = 0; i < count; ++i) {
+        value = co_await next_value(value);
+    }
+    elapsed = aio_clock::now() - start;
+
+    // Also keeps the loop from being optimized away
+    if (value != count) {
+        fail("Coroutine benchmark lost a result");
+    }
+}
+
+bench_result bench_coroutine(const bench_options &options) {
+    // Nothing is buffered, so a single round will do
+    bench_result result = run_rounds(options, std::numeric_limits<uint64_t>::max(), [](uint64_t count) {
+        aio_clock::duration elapsed{};
+        ParallelAIOs tasks{coroutine_round(count, elapsed)};
+        tasks.run();
+        return elapsed;
+    });
+
+    result.bytes = 0;
+    return result;
+}
+
+}  // namespace abel
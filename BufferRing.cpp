@@ -0,0 +1,74 @@
+#include <abel/BufferRing.hpp>
+
+namespace abel {
+
+BufferLease::~BufferLease() noexcept {
+    if (ring) {
+        ring->give_back(idx);
+        ring = nullptr;
+    }
+}
+
+BufferRing::BufferRing(size_t buffer_size, size_t count) :
+    buffer_size{buffer_size},
+    count{count},
+    // Pages that are never borrowed are never touched, so they don't become resident either
+    storage{std::make_unique_for_overwrite<unsigned char[]>(buffer_size * count)} {
+
+    if (buffer_size == 0 || count == 0 || count > UINT32_MAX) {
+        fail("Invalid buffer ring dimensions");
+    }
+
+    free_list.reserve(count);
+    for (size_t i = count; i > 0; --i) {
+        free_list.push_back((uint32_t)(i - 1));
+    }
+}
+
+void BufferRing::give_back(uint32_t idx) noexcept {
+    free_list.push_back(idx);
+    --stats_.in_use;
+    available.signal();
+}
+
+std::optional<BufferLease> BufferRing::try_borrow() {
+    if (free_list.empty()) {
+        available.reset();
+        return std::nullopt;
+    }
+
+    uint32_t idx = free_list.back();
+    free_list.pop_back();
+
+    ++stats_.borrows;
+    ++stats_.in_use;
+    stats_.peak_in_use = std::max<size_t>(stats_.peak_in_use, stats_.in_use);
+
+    return BufferLease(this, idx, {storage.get() + idx * buffer_size, buffer_size});
+}
+
+AIO<BufferLease> BufferRing::borrow_async() {
+    bool waited = false;
+
+    while (true) {
+        std::optional<BufferLease> result = try_borrow();
+        if (result) {
+            co_return std::move(*result);
+        }
+
+        if (!waited) {
+            ++stats_.exhausted;
+            waited = true;
+        }
+        co_await event_signaled{available};
+    }
+}
+
+buffer_ring_stats BufferRing::stats() const noexcept {
+    buffer_ring_stats result = stats_;
+    result.buffer_size = buffer_size;
+    result.capacity = count;
+    return result;
+}
+
+}  // namespace abel
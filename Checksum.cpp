@@ -0,0 +1,246 @@
+#include <abel/Checksum.hpp>
+
+#include <cstring>
+
+#if defined(_M_X64)
+#include <intrin.h>
+#include <nmmintrin.h>
+#endif
+
+namespace abel {
+
+#pragma region impl
+namespace {
+
+// Reflected CRC-32C polynomial
+constexpr uint32_t crc32c_poly = 0x82F63B78;
+
+// Lengths of the three interleaved lanes used by the hardware kernel. The crc32 instruction has
+// a latency of 3 cycles but a throughput of 1 per cycle, so three independent streams keep it busy.
+constexpr size_t lane_long = 8192;
+constexpr size_t lane_short = 256;
+
+uint32_t gf2_matrix_times(const uint32_t *mat, uint32_t vec) noexcept {
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1) {
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        ++mat;
+    }
+    return sum;
+}
+
+void gf2_matrix_square(uint32_t *square, const uint32_t *mat) noexcept {
+    for (unsigned n = 0; n < 32; ++n) {
+        square[n] = gf2_matrix_times(mat, mat[n]);
+    }
+}
+
+// Builds tables that advance a crc over `len` zero bytes (`len` must be a power of two)
+void crc32c_zeros(uint32_t (&zeros)[4][256], size_t len) noexcept {
+    uint32_t even[32]{};
+    uint32_t odd[32]{};
+
+    // Operator for a single zero bit
+    odd[0] = crc32c_poly;
+    for (unsigned n = 1; n < 32; ++n) {
+        odd[n] = 1u << (n - 1);
+    }
+
+    // Two, then four zero bits
+    gf2_matrix_square(even, odd);
+    gf2_matrix_square(odd, even);
+
+    // Keep squaring, starting from a single zero byte
+    const uint32_t *op = nullptr;
+    while (true) {
+        gf2_matrix_square(even, odd);
+        len >>= 1;
+        if (len == 0) {
+            op = even;
+            break;
+        }
+        gf2_matrix_square(odd, even);
+        len >>= 1;
+        if (len == 0) {
+            op = odd;
+            break;
+        }
+    }
+
+    for (uint32_t n = 0; n < 256; ++n) {
+        zeros[0][n] = gf2_matrix_times(op, n);
+        zeros[1][n] = gf2_matrix_times(op, n << 8);
+        zeros[2][n] = gf2_matrix_times(op, n << 16);
+        zeros[3][n] = gf2_matrix_times(op, n << 24);
+    }
+}
+
+uint32_t crc32c_shift(const uint32_t (&zeros)[4][256], uint32_t crc) noexcept {
+    return zeros[0][crc & 0xFF] ^
+           zeros[1][(crc >> 8) & 0xFF] ^
+           zeros[2][(crc >> 16) & 0xFF] ^
+           zeros[3][crc >> 24];
+}
+
+struct crc32c_tables {
+    uint32_t slices[8][256]{};
+    uint32_t zeros_long[4][256]{};
+    uint32_t zeros_short[4][256]{};
+
+    crc32c_tables() noexcept {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t crc = n;
+            for (unsigned k = 0; k < 8; ++k) {
+                crc = crc & 1 ? (crc >> 1) ^ crc32c_poly : crc >> 1;
+            }
+            slices[0][n] = crc;
+        }
+
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t crc = slices[0][n];
+            for (unsigned k = 1; k < 8; ++k) {
+                crc = slices[0][crc & 0xFF] ^ (crc >> 8);
+                slices[k][n] = crc;
+            }
+        }
+
+        crc32c_zeros(zeros_long, lane_long);
+        crc32c_zeros(zeros_short, lane_short);
+    }
+};
+
+const crc32c_tables &tables() noexcept {
+    static const crc32c_tables instance{};
+    return instance;
+}
+
+uint32_t crc32c_sw(uint32_t crc, const unsigned char *next, size_t len) noexcept {
+    const auto &tbl = tables().slices;
+
+    while (len && ((uintptr_t)next & 7) != 0) {
+        crc = tbl[0][(crc ^ *next++) & 0xFF] ^ (crc >> 8);
+        --len;
+    }
+
+    // Note: assumes a little-endian host, which every Windows target is
+    while (len >= 8) {
+        uint64_t word = 0;
+        std::memcpy(&word, next, sizeof(word));
+        word ^= crc;
+        crc = tbl[7][word & 0xFF] ^
+              tbl[6][(word >> 8) & 0xFF] ^
+              tbl[5][(word >> 16) & 0xFF] ^
+              tbl[4][(word >> 24) & 0xFF] ^
+              tbl[3][(word >> 32) & 0xFF] ^
+              tbl[2][(word >> 40) & 0xFF] ^
+              tbl[1][(word >> 48) & 0xFF] ^
+              tbl[0][word >> 56];
+        next += 8;
+        len -= 8;
+    }
+
+    while (len) {
+        crc = tbl[0][(crc ^ *next++) & 0xFF] ^ (crc >> 8);
+        --len;
+    }
+
+    return crc;
+}
+
+#if defined(_M_X64)
+uint64_t load_u64(const unsigned char *ptr) noexcept {
+    uint64_t result = 0;
+    std::memcpy(&result, ptr, sizeof(result));
+    return result;
+}
+
+// Processes 3 * lane bytes as three independent streams and merges them by shifting the
+// earlier ones over the length of the later ones
+template <size_t lane>
+uint64_t crc32c_hw_lanes(uint64_t crc0, const unsigned char *&next, size_t &len, const uint32_t (&zeros)[4][256]) noexcept {
+    while (len >= lane * 3) {
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+        const unsigned char *end = next + lane;
+        do {
+            crc0 = _mm_crc32_u64(crc0, load_u64(next));
+            crc1 = _mm_crc32_u64(crc1, load_u64(next + lane));
+            crc2 = _mm_crc32_u64(crc2, load_u64(next + lane * 2));
+            next += 8;
+        } while (next < end);
+        crc0 = crc32c_shift(zeros, (uint32_t)crc0) ^ crc1;
+        crc0 = crc32c_shift(zeros, (uint32_t)crc0) ^ crc2;
+        next += lane * 2;
+        len -= lane * 3;
+    }
+    return crc0;
+}
+
+uint32_t crc32c_hw(uint32_t crc, const unsigned char *next, size_t len) noexcept {
+    const auto &tbl = tables();
+
+    uint64_t crc0 = crc;
+
+    while (len && ((uintptr_t)next & 7) != 0) {
+        crc0 = _mm_crc32_u8((uint32_t)crc0, *next++);
+        --len;
+    }
+
+    crc0 = crc32c_hw_lanes<lane_long>(crc0, next, len, tbl.zeros_long);
+    crc0 = crc32c_hw_lanes<lane_short>(crc0, next, len, tbl.zeros_short);
+
+    while (len >= 8) {
+        crc0 = _mm_crc32_u64(crc0, load_u64(next));
+        next += 8;
+        len -= 8;
+    }
+
+    while (len) {
+        crc0 = _mm_crc32_u8((uint32_t)crc0, *next++);
+        --len;
+    }
+
+    return (uint32_t)crc0;
+}
+
+bool cpu_has_sse42() noexcept {
+    int info[4]{};
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+}
+#endif
+
+using crc32c_kernel_t = uint32_t (*)(uint32_t crc, const unsigned char *next, size_t len) noexcept;
+
+crc32c_kernel_t select_kernel() noexcept {
+#if defined(_M_X64)
+    if (cpu_has_sse42()) {
+        return &crc32c_hw;
+    }
+#endif
+    return &crc32c_sw;
+}
+
+crc32c_kernel_t kernel() noexcept {
+    static const crc32c_kernel_t instance = select_kernel();
+    return instance;
+}
+
+}  // namespace
+#pragma endregion impl
+
+void Crc32c::update(std::span<const unsigned char> data) noexcept {
+    if (data.empty()) {
+        return;
+    }
+    state = kernel()(state, data.data(), data.size());
+}
+
+bool Crc32c::hardware_accelerated() noexcept {
+    return kernel() != &crc32c_sw;
+}
+
+}  // namespace abel
@@ -1,7 +1,60 @@
 #include <abel/Concurrency.hpp>
 
+#include <algorithm>
+
 namespace abel {
 
+#pragma region PendingIO
+PendingIO::~PendingIO() noexcept {
+    cancel();
+}
+
+OVERLAPPED *PendingIO::prepare(Handle target, uint64_t offset) noexcept {
+    // Just in case the previous request is still running
+    cancel();
+
+    target_ = target;
+    overlapped_ = OVERLAPPED{.hEvent = done_.raw()};
+    overlapped_.Offset = (DWORD)(offset & 0xFFFFFFFF);
+    overlapped_.OffsetHigh = (DWORD)(offset >> 32);
+
+    return &overlapped_;
+}
+
+eof<size_t> PendingIO::result() {
+    DWORD transmitted = 0;
+    bool success = GetOverlappedResult(
+        target_.raw(),
+        &overlapped_,
+        &transmitted,
+        true
+    );
+
+    if (!success) {
+        switch (GetLastError()) {
+        case ERROR_HANDLE_EOF:
+        case ERROR_BROKEN_PIPE:
+            return eof((size_t)transmitted, true);
+        default:
+            fail("Failed to get overlapped operation result");
+        }
+    }
+
+    return eof((size_t)transmitted, transmitted == 0);
+}
+
+void PendingIO::cancel() noexcept {
+    if (!target_ || is_done()) {
+        return;
+    }
+
+    CancelIoEx(target_.raw(), &overlapped_);
+
+    DWORD transmitted = 0;
+    GetOverlappedResult(target_.raw(), &overlapped_, &transmitted, true);
+}
+#pragma endregion PendingIO
+
 void AIOEnv::update_current(std::coroutine_handle<> prev, std::coroutine_handle<> coro) noexcept {
     if (current_ != prev) {
         fail("Nonlinear use of AIOEnv detected");
@@ -16,6 +69,8 @@ void AIOEnv::step() {
     if (non_io_event_ && non_io_event_.is_signaled()) {
         // We cannot reset non_io_event_, since it might not be an event at all
         non_io_event_ = nullptr;
+    } else if (deadline_ && aio_clock::now() >= *deadline_) {
+        deadline_.reset();
     } else if (io_done_.is_signaled()) {
         io_done_.reset();
     } else {
@@ -45,6 +100,23 @@ void ParallelAIOs::wait_any(DWORD miliseconds) {
         targets = targets.subspan(1);
     }
 
+    std::optional<aio_clock::time_point> nearest{};
+    for (size_t i = 0; i < size(); ++i) {
+        const auto &deadline = envs[i].deadline();
+        if (deadline && (!nearest || *deadline < *nearest)) {
+            nearest = deadline;
+        }
+    }
+
+    if (nearest) {
+        auto remaining = std::chrono::ceil<std::chrono::milliseconds>(*nearest - aio_clock::now()).count();
+        remaining = std::max<decltype(remaining)>(remaining, 0);
+        if (miliseconds == INFINITE || (uint64_t)remaining < miliseconds) {
+            // INFINITE is -1, so this also keeps us from accidentally waiting forever
+            miliseconds = (DWORD)std::min<uint64_t>(remaining, INFINITE - 1);
+        }
+    }
+
     Handle::wait_multiple(targets, false, miliseconds);
 }
 
@@ -75,4 +147,154 @@ void ParallelAIOs::run() {
     }
 }
 
+bool ParallelAIOs::run_until(aio_clock::time_point deadline) {
+    while (!done()) {
+        auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - aio_clock::now()).count();
+        if (remaining <= 0) {
+            return false;
+        }
+
+        wait_any((DWORD)std::min<uint64_t>(remaining, INFINITE - 1));
+        step();
+    }
+    return true;
+}
+
+#pragma region TaskSet
+TaskSet::entry::entry(TaskSet *owner, uint64_t id, AIO<void> task_) :
+    owner{owner}, id{id}, task{std::move(task_)} {
+
+    env.attach(task);
+
+    wait = CreateThreadpoolWait(&TaskSet::on_wait, this, nullptr);
+    if (!wait) {
+        fail("Failed to create thread pool wait");
+    }
+}
+
+TaskSet::entry::~entry() noexcept {
+    // The callback must be done with us before we go away
+    SetThreadpoolWait(wait, nullptr, nullptr);
+    WaitForThreadpoolWaitCallbacks(wait, true);
+    CloseThreadpoolWait(wait);
+
+    // A task destroyed mid-flight may have left an operation pending, and the kernel would complete it
+    // into our OVERLAPPED after we're gone. It's up to whoever destroys it to have cancelled that first
+    while (env.io_pending()) {
+        Sleep(1);
+    }
+}
+
+TaskSet::~TaskSet() noexcept {
+    clear();
+}
+
+void CALLBACK TaskSet::on_wait(PTP_CALLBACK_INSTANCE, void *context, PTP_WAIT, TP_WAIT_RESULT) {
+    // Timeouts too: the task checks for itself whether its deadline has passed
+    entry *target = (entry *)context;
+    target->owner->schedule(target->id);
+}
+
+void TaskSet::schedule(uint64_t id) {
+    {
+        std::lock_guard lock{ready_mutex};
+        ready_ids.push_back(id);
+    }
+    ready.signal();
+}
+
+void TaskSet::arm(entry &target) {
+    FILETIME timeout{};
+    FILETIME *timeout_ptr = nullptr;
+
+    const auto &deadline = target.env.deadline();
+    if (deadline) {
+        auto remaining = *deadline - aio_clock::now();
+        if (remaining <= aio_clock::duration::zero()) {
+            schedule(target.id);
+            return;
+        }
+
+        // Negative values are relative, in 100ns units
+        using ticks = std::chrono::duration<int64_t, std::ratio<1, 10'000'000>>;
+        int64_t relative = -std::chrono::ceil<ticks>(remaining).count();
+        timeout.dwLowDateTime = (DWORD)((uint64_t)relative & 0xFFFFFFFF);
+        timeout.dwHighDateTime = (DWORD)((uint64_t)relative >> 32);
+        timeout_ptr = &timeout;
+    }
+
+    SetThreadpoolWait(target.wait, target.env.event_done().raw(), timeout_ptr);
+}
+
+void TaskSet::add(AIO<void> task) {
+    uint64_t id = next_id++;
+    entries.emplace(id, std::make_unique<entry>(this, id, std::move(task)));
+
+    // The first step starts it
+    schedule(id);
+}
+
+void TaskSet::step_ready() {
+    std::vector<uint64_t> batch{};
+    {
+        std::lock_guard lock{ready_mutex};
+        batch.swap(ready_ids);
+    }
+
+    for (uint64_t id : batch) {
+        auto it = entries.find(id);
+        if (it == entries.end()) {
+            // Finished while a wakeup was still queued
+            continue;
+        }
+
+        // Stepping may add tasks and so rehash the map, but the entry itself stays in place
+        entry &target = *it->second;
+        target.env.step();
+
+        if (target.env.current() == nullptr) {
+            entries.erase(id);
+            continue;
+        }
+
+        arm(target);
+    }
+}
+
+void TaskSet::run(Handle stop) {
+    while (!empty()) {
+        if (stop) {
+            if (Handle::wait_multiple(stop, ready) == 0) {
+                return;
+            }
+        } else {
+            ready.wait();
+        }
+
+        step_ready();
+    }
+}
+
+bool TaskSet::run_until(aio_clock::time_point deadline) {
+    while (!empty()) {
+        auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - aio_clock::now()).count();
+        if (remaining <= 0) {
+            return false;
+        }
+
+        if (ready.wait_timeout((DWORD)std::min<uint64_t>(remaining, INFINITE - 1))) {
+            step_ready();
+        }
+    }
+    return true;
+}
+
+void TaskSet::clear() noexcept {
+    entries.clear();
+
+    std::lock_guard lock{ready_mutex};
+    ready_ids.clear();
+}
+#pragma endregion TaskSet
+
 }  // namespace abel
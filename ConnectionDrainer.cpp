@@ -0,0 +1,148 @@
+#include <abel/ConnectionDrainer.hpp>
+#include <abel/ShardedListener.hpp>
+
+#include <utility>
+
+namespace abel {
+
+#pragma region DrainTicket
+DrainTicket::DrainTicket(DrainTicket &&other) noexcept :
+    owner{std::exchange(other.owner, nullptr)}, id{other.id} {
+}
+
+DrainTicket &DrainTicket::operator=(DrainTicket &&other) noexcept {
+    if (this != &other) {
+        if (owner) {
+            owner->release(id);
+        }
+        owner = std::exchange(other.owner, nullptr);
+        id = other.id;
+    }
+    return *this;
+}
+
+DrainTicket::~DrainTicket() noexcept {
+    if (owner) {
+        owner->release(id);
+    }
+}
+
+bool DrainTicket::draining() const noexcept {
+    return owner && owner->draining();
+}
+
+void DrainTicket::set_idle(bool idle) noexcept {
+    if (!owner) {
+        return;
+    }
+
+    auto it = owner->connections.find(id);
+    if (it != owner->connections.end()) {
+        it->second.idle = idle;
+    }
+}
+
+void DrainTicket::finish() noexcept {
+    if (!owner) {
+        return;
+    }
+
+    // Aborted connections are no longer registered
+    auto it = owner->connections.find(id);
+    if (it != owner->connections.end()) {
+        ConnectionDrainer::finish(it->second);
+    }
+}
+#pragma endregion DrainTicket
+
+#pragma region ConnectionDrainer
+void ConnectionDrainer::add_acceptor(PendingAccept &accept) {
+    acceptors.push_back(&accept);
+    if (draining_) {
+        accept.stop();
+    }
+}
+
+DrainTicket ConnectionDrainer::track(Socket socket) {
+    uint64_t id = next_id++;
+    connections.emplace(id, connection{.socket = socket});
+    return DrainTicket(this, id);
+}
+
+void ConnectionDrainer::finish(connection &conn) noexcept {
+    if (conn.finished) {
+        return;
+    }
+    conn.finished = true;
+
+    // The peer may well be gone already, which is fine
+    ::shutdown(conn.socket.raw(), SD_SEND);
+}
+
+void ConnectionDrainer::release(uint64_t id) noexcept {
+    auto it = connections.find(id);
+    if (it == connections.end()) {
+        // Already counted as aborted
+        return;
+    }
+    connections.erase(it);
+
+    if (draining_) {
+        ++stats_.drained;
+        if (connections.empty()) {
+            stats_.drain_time = aio_clock::now() - drain_start;
+        }
+    }
+}
+
+void ConnectionDrainer::begin_drain() {
+    if (draining_) {
+        return;
+    }
+    draining_ = true;
+    drain_start = aio_clock::now();
+
+    for (PendingAccept *accept : acceptors) {
+        accept->stop();
+    }
+
+    for (auto &[id, conn] : connections) {
+        if (conn.idle) {
+            finish(conn);
+        }
+    }
+}
+
+void ConnectionDrainer::abort_remaining() noexcept {
+    for (auto &[id, conn] : connections) {
+        // A zero linger timeout makes the eventual closesocket send a reset instead of waiting
+        LINGER linger{.l_onoff = 1, .l_linger = 0};
+        setsockopt(conn.socket.raw(), SOL_SOCKET, SO_LINGER, (const char *)&linger, sizeof(linger));
+
+        // Whoever is waiting on the socket gets an error and lets go of it
+        CancelIoEx(conn.socket.io_handle().raw(), nullptr);
+
+        ++stats_.aborted;
+    }
+
+    if (draining_ && !connections.empty()) {
+        stats_.drain_time = aio_clock::now() - drain_start;
+    }
+    connections.clear();
+}
+
+void ConnectionDrainer::drain(TaskSet &tasks, aio_clock::time_point deadline) {
+    begin_drain();
+    if (tasks.run_until(deadline)) {
+        return;
+    }
+
+    abort_remaining();
+    // Their IO is cancelled, so this doesn't normally take long, but a handler may still
+    // be stuck on something else; we can't wait on it forever
+    tasks.run_until(aio_clock::now() + unwind_timeout);
+    tasks.clear();
+}
+#pragma endregion ConnectionDrainer
+
+}  // namespace abel
@@ -0,0 +1,140 @@
+#include <abel/ConnectionPool.hpp>
+
+#include <algorithm>
+
+namespace abel {
+
+#pragma region PooledSocket
+PooledSocket::~PooledSocket() noexcept {
+    if (pool) {
+        pool->release(ConnectionPool::key{host, port}, std::move(socket_), true);
+        pool = nullptr;
+    }
+}
+
+void PooledSocket::discard() noexcept {
+    if (pool) {
+        pool->release(ConnectionPool::key{host, port}, std::move(socket_), false);
+        pool = nullptr;
+    }
+}
+#pragma endregion PooledSocket
+
+#pragma region ConnectionPool
+bool ConnectionPool::is_alive(Socket socket) {
+    WSAPOLLFD fd{
+        .fd = socket.raw(),
+        .events = POLLRDNORM,
+    };
+
+    int status = WSAPoll(&fd, 1, 0);
+    if (status == SOCKET_ERROR) {
+        return false;
+    }
+
+    return !(fd.revents & (POLLRDNORM | POLLERR | POLLHUP | POLLNVAL));
+}
+
+void ConnectionPool::release(const key &k, OwningSocket socket, bool reusable) noexcept {
+    bucket &target = buckets[k];
+
+    if (reusable && socket && target.idle.size() < options.max_idle) {
+        target.idle.push_back(idle_connection{std::move(socket), aio_clock::now()});
+    } else {
+        // The socket gets closed on scope exit
+        --target.total;
+    }
+
+    released.signal();
+}
+
+void ConnectionPool::record_latency(aio_clock::time_point start) noexcept {
+    aio_clock::duration latency = aio_clock::now() - start;
+    stats_.total_checkout_latency += latency;
+    stats_.max_checkout_latency = std::max<aio_clock::duration>(stats_.max_checkout_latency, latency);
+}
+
+void ConnectionPool::evict_idle() {
+    aio_clock::time_point cutoff = aio_clock::now() - options.idle_timeout;
+
+    for (auto &[k, target] : buckets) {
+        // The oldest ones are at the front
+        while (!target.idle.empty() && target.idle.front().since < cutoff) {
+            target.idle.pop_front();
+            --target.total;
+            ++stats_.evicted;
+        }
+    }
+}
+
+size_t ConnectionPool::idle_count() const noexcept {
+    size_t result = 0;
+    for (const auto &[k, target] : buckets) {
+        result += target.idle.size();
+    }
+    return result;
+}
+
+AIO<PooledSocket> ConnectionPool::checkout_async(std::string host, uint16_t port, aio_clock::time_point deadline) {
+    aio_clock::time_point start = aio_clock::now();
+    ++stats_.checkouts;
+
+    key k{host, port};
+    bool waited = false;
+
+    while (true) {
+        evict_idle();
+
+        // Note: buckets are never erased, so this stays valid across suspensions
+        bucket &target = buckets[k];
+
+        while (!target.idle.empty()) {
+            // The most recently used one is the most likely to still be alive
+            OwningSocket socket = std::move(target.idle.back().socket);
+            target.idle.pop_back();
+
+            if (is_alive(socket)) {
+                ++stats_.reused;
+                record_latency(start);
+                co_return PooledSocket(this, host, port, std::move(socket));
+            }
+
+            --target.total;
+            ++stats_.broken;
+        }
+
+        if (target.total < options.max_total) {
+            // Reserve the slot before suspending, so that concurrent checkouts respect the limit
+            ++target.total;
+
+            OwningSocket socket{};
+            try {
+                socket = co_await Socket::connect_async(host, port, deadline);
+            } catch (...) {
+                --target.total;
+                released.signal();
+                throw;
+            }
+
+            ++stats_.created;
+            record_latency(start);
+            co_return PooledSocket(this, host, port, std::move(socket));
+        }
+
+        if (!waited) {
+            ++stats_.waited;
+            waited = true;
+        }
+
+        // Nothing is released while we aren't suspended, so no signal can get lost here
+        released.reset();
+        bool signaled = co_await event_signaled_until{released, deadline};
+        if (!signaled) {
+            ++stats_.timeouts;
+            fail("Timed out waiting for a pooled connection");
+        }
+    }
+}
+#pragma endregion ConnectionPool
+
+}  // namespace abel
@@ -0,0 +1,419 @@
+#include <abel/DatagramSocket.hpp>
+
+#include <mstcpip.h>
+#include <memory>
+#include <cstring>
+
+namespace abel {
+
+#pragma region endpoint
+endpoint endpoint::resolve(const std::string &host, uint16_t port, int family) {
+    addrinfo hints{
+        .ai_family = family,
+        .ai_socktype = SOCK_DGRAM,
+        .ai_protocol = IPPROTO_UDP,
+    };
+    addrinfo *raw_addrs = nullptr;
+
+    int status = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &raw_addrs);
+    if (status != 0) {
+        fail_ws("Failed to resolve host", status);
+    }
+    std::unique_ptr<addrinfo, decltype(&freeaddrinfo)> addrs{raw_addrs, &freeaddrinfo};
+
+    endpoint result{};
+    std::memcpy(&result.storage, raw_addrs->ai_addr, raw_addrs->ai_addrlen);
+    result.length = (int)raw_addrs->ai_addrlen;
+    return result;
+}
+
+endpoint endpoint::any(uint16_t port, int family) {
+    endpoint result{};
+
+    switch (family) {
+    case AF_INET: {
+        auto &addr = (sockaddr_in &)result.storage;
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = INADDR_ANY;
+        result.length = sizeof(sockaddr_in);
+    } break;
+
+    case AF_INET6: {
+        auto &addr = (sockaddr_in6 &)result.storage;
+        addr.sin6_family = AF_INET6;
+        addr.sin6_port = htons(port);
+        addr.sin6_addr = in6addr_any;
+        result.length = sizeof(sockaddr_in6);
+    } break;
+
+    default:
+        fail("Unsupported address family");
+    }
+
+    return result;
+}
+
+uint16_t endpoint::port() const noexcept {
+    switch (family()) {
+    case AF_INET:
+        return ntohs(((const sockaddr_in &)storage).sin_port);
+    case AF_INET6:
+        return ntohs(((const sockaddr_in6 &)storage).sin6_port);
+    default:
+        return 0;
+    }
+}
+#pragma endregion endpoint
+
+#pragma region DatagramSocket
+// Buffers for WSARecvMsg, which have to outlive the call
+struct _impl_RecvMsgData {
+    WSABUF wsabuf;
+    sockaddr_storage from{};
+    alignas(WSACMSGHDR) char control[WSA_CMSG_SPACE(sizeof(DWORD))]{};
+    WSAMSG msg;
+
+    _impl_RecvMsgData(std::span<unsigned char> data) :
+        wsabuf{.len = (ULONG)data.size(), .buf = (char *)data.data()},
+        msg{
+            .name = (sockaddr *)&from,
+            .namelen = sizeof(from),
+            .lpBuffers = &wsabuf,
+            .dwBufferCount = 1,
+            .Control = {.len = sizeof(control), .buf = control},
+            .dwFlags = 0,
+        } {
+    }
+
+    received_datagram finish(std::span<unsigned char> data, DWORD received, bool truncated) {
+        received_datagram result{
+            .data = data.subspan(0, received),
+            .segment_size = received,
+            .truncated = truncated,
+        };
+
+        std::memcpy(&result.from.storage, &from, msg.namelen);
+        result.from.length = msg.namelen;
+
+        for (WSACMSGHDR *header = WSA_CMSG_FIRSTHDR(&msg); header; header = WSA_CMSG_NXTHDR(&msg, header)) {
+            if (header->cmsg_level == IPPROTO_UDP && header->cmsg_type == UDP_COALESCED_INFO) {
+                result.segment_size = *(DWORD *)WSA_CMSG_DATA(header);
+            }
+        }
+
+        return result;
+    }
+};
+
+DatagramSocket::DatagramSocket(OwningSocket socket) :
+    socket_{std::move(socket)} {
+
+    socket_.validate();
+
+    // Otherwise an ICMP port unreachable reply to one of our sends fails the next receive
+    BOOL report = false;
+    DWORD returned = 0;
+    WSAIoctl(socket_.raw(), SIO_UDP_CONNRESET, &report, sizeof(report), nullptr, 0, &returned, nullptr, nullptr);
+
+    GUID guid = WSAID_WSARECVMSG;
+    int status = WSAIoctl(
+        socket_.raw(),
+        SIO_GET_EXTENSION_FUNCTION_POINTER,
+        &guid,
+        sizeof(guid),
+        &recv_msg,
+        sizeof(recv_msg),
+        &returned,
+        nullptr,
+        nullptr
+    );
+    if (status == SOCKET_ERROR) {
+        fail_ws("Failed to get WSARecvMsg");
+    }
+}
+
+DatagramSocket DatagramSocket::create(int family) {
+    return DatagramSocket(Socket::create(family, SOCK_DGRAM, IPPROTO_UDP));
+}
+
+DatagramSocket DatagramSocket::bind(uint16_t port, int family) {
+    DatagramSocket result = create(family);
+
+    endpoint local = endpoint::any(port, family);
+    int status = ::bind(result.socket_.raw(), local.raw(), local.length);
+    if (status == SOCKET_ERROR) {
+        fail_ws("Failed to bind socket");
+    }
+
+    return result;
+}
+
+endpoint DatagramSocket::local_endpoint() const {
+    endpoint result{};
+    result.length = sizeof(result.storage);
+
+    int status = getsockname(socket_.raw(), result.raw(), &result.length);
+    if (status == SOCKET_ERROR) {
+        fail_ws("Failed to get socket name");
+    }
+
+    return result;
+}
+
+bool DatagramSocket::enable_offloads(DWORD max_coalesced) {
+    // Querying fails if segmentation offload isn't supported at all
+    DWORD value = 0;
+    int length = sizeof(value);
+    send_offload = getsockopt(socket_.raw(), IPPROTO_UDP, UDP_SEND_MSG_SIZE, (char *)&value, &length) != SOCKET_ERROR;
+
+    int status = setsockopt(
+        socket_.raw(),
+        IPPROTO_UDP,
+        UDP_RECV_MAX_COALESCED_SIZE,
+        (const char *)&max_coalesced,
+        sizeof(max_coalesced)
+    );
+    recv_offload = status != SOCKET_ERROR ? max_coalesced : 0;
+
+    return send_offload || recv_offload;
+}
+
+size_t DatagramSocket::send_to(std::span<const unsigned char> data, const endpoint &to) {
+    int sent = ::sendto(socket_.raw(), (const char *)data.data(), (int)data.size(), 0, to.raw(), to.length);
+    if (sent == SOCKET_ERROR) {
+        fail_ws("Failed to send datagram");
+    }
+
+    return (size_t)sent;
+}
+
+std::optional<received_datagram> DatagramSocket::recv_msg_sync(std::span<unsigned char> data) {
+    auto wsadata = std::make_unique<_impl_RecvMsgData>(data);
+
+    DWORD received = 0;
+    int status = recv_msg(socket_.raw(), &wsadata->msg, &received, nullptr, nullptr);
+
+    bool truncated = false;
+    if (status == SOCKET_ERROR) {
+        switch (WSAGetLastError()) {
+        case WSAEMSGSIZE:
+            truncated = true;
+            received = (DWORD)data.size();
+            break;
+        case WSAEWOULDBLOCK:
+            return std::nullopt;
+        default:
+            fail_ws("Failed to receive datagram");
+        }
+    }
+
+    return wsadata->finish(data, received, truncated || (wsadata->msg.dwFlags & MSG_TRUNC));
+}
+
+received_datagram DatagramSocket::recv_from(std::span<unsigned char> data) {
+    // Blocking, so there is always something
+    return *recv_msg_sync(data);
+}
+
+AIO<size_t> DatagramSocket::send_to_async(std::span<const unsigned char> data, const endpoint &to) {
+    auto &env = *co_await current_env{};
+    WSAOVERLAPPED *overlapped = (WSAOVERLAPPED *)env.overlapped();
+
+    // Note: const violation is okay because WSASendTo mustn't write to this buffer
+    auto wsabuf = std::make_unique<WSABUF>(WSABUF{.len = (ULONG)data.size(), .buf = (char *)data.data()});
+
+    int status = WSASendTo(
+        socket_.raw(),
+        wsabuf.get(),
+        1,
+        nullptr,
+        0,
+        to.raw(),
+        to.length,
+        overlapped,
+        nullptr
+    );
+
+    if (status == SOCKET_ERROR && WSAGetLastError() != WSA_IO_PENDING) {
+        fail_ws("Failed to initiate asynchronous datagram send");
+    }
+
+    co_await io_done_signaled{};
+
+    DWORD transmitted = 0;
+    DWORD flags = 0;
+    bool success = WSAGetOverlappedResult(socket_.raw(), overlapped, &transmitted, false, &flags);
+    if (!success) {
+        fail_ws("Failed to get overlapped operation result");
+    }
+
+    co_return (size_t)transmitted;
+}
+
+AIO<received_datagram> DatagramSocket::recv_from_async(std::span<unsigned char> data) {
+    auto &env = *co_await current_env{};
+    WSAOVERLAPPED *overlapped = (WSAOVERLAPPED *)env.overlapped();
+
+    auto wsadata = std::make_unique<_impl_RecvMsgData>(data);
+
+    int status = recv_msg(socket_.raw(), &wsadata->msg, nullptr, overlapped, nullptr);
+    if (status == SOCKET_ERROR) {
+        switch (WSAGetLastError()) {
+        case WSA_IO_PENDING:
+            break;
+        case WSAEMSGSIZE:
+            co_return wsadata->finish(data, (DWORD)data.size(), true);
+        default:
+            fail_ws("Failed to initiate asynchronous datagram receive");
+        }
+    }
+
+    co_await io_done_signaled{};
+
+    DWORD received = 0;
+    DWORD flags = 0;
+    bool success = WSAGetOverlappedResult(socket_.raw(), overlapped, &received, false, &flags);
+
+    bool truncated = false;
+    if (!success) {
+        if (WSAGetLastError() != WSAEMSGSIZE) {
+            fail_ws("Failed to get overlapped operation result");
+        }
+        truncated = true;
+        received = (DWORD)data.size();
+    }
+
+    co_return wsadata->finish(data, received, truncated || (flags & MSG_TRUNC));
+}
+
+size_t DatagramSocket::send_offloaded(std::span<const std::span<const unsigned char>> payloads, const endpoint &to) {
+    WSABUF bufs[max_send_offload_count]{};
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        // Note: const violation is okay because WSASendMsg mustn't write to these buffers
+        bufs[i] = WSABUF{.len = (ULONG)payloads[i].size(), .buf = (char *)payloads[i].data()};
+    }
+
+    alignas(WSACMSGHDR) char control[WSA_CMSG_SPACE(sizeof(DWORD))]{};
+    WSAMSG msg{
+        .name = (sockaddr *)to.raw(),
+        .namelen = to.length,
+        .lpBuffers = bufs,
+        .dwBufferCount = (ULONG)payloads.size(),
+        .Control = {.len = sizeof(control), .buf = control},
+        .dwFlags = 0,
+    };
+
+    // The stack splits the concatenated buffers back into datagrams of this size
+    WSACMSGHDR *header = WSA_CMSG_FIRSTHDR(&msg);
+    header->cmsg_len = WSA_CMSG_LEN(sizeof(DWORD));
+    header->cmsg_level = IPPROTO_UDP;
+    header->cmsg_type = UDP_SEND_MSG_SIZE;
+    *(DWORD *)WSA_CMSG_DATA(header) = (DWORD)payloads[0].size();
+
+    DWORD sent = 0;
+    int status = WSASendMsg(socket_.raw(), &msg, 0, &sent, nullptr, nullptr);
+    if (status == SOCKET_ERROR) {
+        fail_ws("Failed to send datagram batch");
+    }
+
+    return payloads.size();
+}
+
+size_t DatagramSocket::send_batch(std::span<const std::span<const unsigned char>> payloads, const endpoint &to) {
+    size_t sent = 0;
+    size_t i = 0;
+
+    while (i < payloads.size()) {
+        size_t end = i;
+
+        if (send_offload) {
+            // Collect a run of equally sized datagrams. Only the last one may be shorter
+            size_t segment = payloads[i].size();
+            size_t total = 0;
+            while (
+                end < payloads.size() &&
+                end - i < max_send_offload_count &&
+                payloads[end].size() <= segment &&
+                total + payloads[end].size() <= max_send_offload
+            ) {
+                total += payloads[end].size();
+                ++end;
+
+                if (payloads[end - 1].size() < segment) {
+                    break;
+                }
+            }
+        }
+
+        if (end - i > 1 && payloads[i].size() > 0) {
+            sent += send_offloaded(payloads.subspan(i, end - i), to);
+            i = end;
+        } else {
+            send_to(payloads[i], to);
+            ++sent;
+            ++i;
+        }
+    }
+
+    return sent;
+}
+
+size_t DatagramSocket::batch_slot(std::span<unsigned char> buffer, std::span<received_datagram> out, size_t max_datagram) const {
+    size_t slot = recv_offload ? (size_t)recv_offload : max_datagram;
+
+    if (out.empty() || buffer.size() < slot) {
+        fail("Batch receive buffer is too small");
+    }
+
+    return slot;
+}
+
+size_t DatagramSocket::recv_queued(std::span<unsigned char> buffer, std::span<received_datagram> out, size_t slot) {
+    if (out.empty() || buffer.size() < slot) {
+        return 0;
+    }
+
+    size_t count = 0;
+    size_t used = 0;
+
+    socket_.set_nonblocking(true);
+    try {
+        while (count < out.size() && buffer.size() - used >= slot) {
+            std::optional<received_datagram> datagram = recv_msg_sync(buffer.subspan(used, slot));
+            if (!datagram) {
+                break;
+            }
+
+            out[count] = *datagram;
+            // Pack them tightly, since datagrams are usually much smaller than the slot
+            used += out[count].data.size();
+            ++count;
+        }
+    } catch (...) {
+        socket_.set_nonblocking(false);
+        throw;
+    }
+    socket_.set_nonblocking(false);
+
+    return count;
+}
+
+size_t DatagramSocket::recv_batch(std::span<unsigned char> buffer, std::span<received_datagram> out, size_t max_datagram) {
+    size_t slot = batch_slot(buffer, out, max_datagram);
+
+    out[0] = *recv_msg_sync(buffer.subspan(0, slot));
+
+    return 1 + recv_queued(buffer.subspan(out[0].data.size()), out.subspan(1), slot);
+}
+
+AIO<size_t> DatagramSocket::recv_batch_async(std::span<unsigned char> buffer, std::span<received_datagram> out, size_t max_datagram) {
+    size_t slot = batch_slot(buffer, out, max_datagram);
+
+    out[0] = co_await recv_from_async(buffer.subspan(0, slot));
+
+    co_return 1 + recv_queued(buffer.subspan(out[0].data.size()), out.subspan(1), slot);
+}
+#pragma endregion DatagramSocket
+
+}  // namespace abel
@@ -0,0 +1,143 @@
+#include <abel/DirectFile.hpp>
+
+#include <malloc.h>
+#include <algorithm>
+
+namespace abel {
+
+#pragma region AlignedBuffer
+AlignedBuffer::AlignedBuffer(size_t size, size_t alignment) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        fail("Alignment must be a power of two");
+    }
+
+    data_ = (unsigned char *)_aligned_malloc(std::max<size_t>(size, 1), alignment);
+    if (!data_) {
+        fail("Failed to allocate aligned buffer");
+    }
+    size_ = size;
+}
+
+AlignedBuffer::~AlignedBuffer() noexcept {
+    if (data_) {
+        _aligned_free(data_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+#pragma endregion AlignedBuffer
+
+#pragma region DirectFile
+DirectFile DirectFile::open(
+    const std::string &path,
+    DWORD access,
+    DWORD creationDisposition,
+    bool writeThrough
+) {
+    DWORD flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED;
+    if (writeThrough) {
+        flags |= FILE_FLAG_WRITE_THROUGH;
+    }
+
+    DirectFile result{};
+    result.file = Handle::open_file(path, access, creationDisposition, flags);
+
+    FILE_STORAGE_INFO info{};
+    bool success = GetFileInformationByHandleEx(result.file.raw(), FileStorageInfo, &info, sizeof(info));
+
+    if (success) {
+        result.alignment_ = std::max<size_t>(
+            info.LogicalBytesPerSector,
+            info.PhysicalBytesPerSectorForPerformance
+        );
+    }
+
+    if (!success || result.alignment_ == 0 || (result.alignment_ & (result.alignment_ - 1)) != 0) {
+        // A page is a safe bet for any common device
+        result.alignment_ = 4096;
+    }
+
+    return result;
+}
+
+AlignedBuffer DirectFile::allocate(size_t size) const {
+    size = (size + alignment_ - 1) / alignment_ * alignment_;
+    return AlignedBuffer(size, alignment_);
+}
+
+void DirectFile::validate_request(uint64_t offset, const void *data, size_t size) const {
+    if (offset % alignment_ != 0) {
+        fail("Unaligned file offset for direct IO");
+    }
+    if ((uintptr_t)data % alignment_ != 0) {
+        fail("Unaligned buffer address for direct IO");
+    }
+    if (size % alignment_ != 0) {
+        fail("Unaligned transfer size for direct IO");
+    }
+}
+
+void DirectFile::seek(uint64_t offset) {
+    if (offset % alignment_ != 0) {
+        fail("Unaligned file offset for direct IO");
+    }
+    position = offset;
+}
+
+eof<size_t> DirectFile::read_at(uint64_t offset, std::span<unsigned char> data) {
+    validate_request(offset, data.data(), data.size());
+    return file.read_at(offset, data);
+}
+
+eof<size_t> DirectFile::write_at(uint64_t offset, std::span<const unsigned char> data) {
+    validate_request(offset, data.data(), data.size());
+    return file.write_at(offset, data);
+}
+
+AIO<eof<size_t>> DirectFile::read_async_at(uint64_t offset, std::span<unsigned char> data) {
+    validate_request(offset, data.data(), data.size());
+    co_return co_await file.read_async_at(offset, data);
+}
+
+AIO<eof<size_t>> DirectFile::write_async_at(uint64_t offset, std::span<const unsigned char> data) {
+    validate_request(offset, data.data(), data.size());
+    co_return co_await file.write_async_at(offset, data);
+}
+
+// Note: the position can only become unaligned after a short read at the end of file,
+// so the streaming reads below report eof in that case instead of failing validation
+
+eof<size_t> DirectFile::read_into(std::span<unsigned char> data) {
+    if (position % alignment_ != 0) {
+        return eof((size_t)0, true);
+    }
+
+    eof<size_t> result = read_at(position, data);
+    position += result.value;
+    return result;
+}
+
+eof<size_t> DirectFile::write_from(std::span<const unsigned char> data) {
+    eof<size_t> result = write_at(position, data);
+    position += result.value;
+    return result;
+}
+
+AIO<eof<size_t>> DirectFile::read_async_into(std::span<unsigned char> data) {
+    if (position % alignment_ != 0) {
+        co_return eof((size_t)0, true);
+    }
+
+    eof<size_t> result = co_await read_async_at(position, data);
+    position += result.value;
+    co_return result;
+}
+
+AIO<eof<size_t>> DirectFile::write_async_from(std::span<const unsigned char> data) {
+    eof<size_t> result = co_await write_async_at(position, data);
+    position += result.value;
+    co_return result;
+}
+#pragma endregion DirectFile
+
+}  // namespace abel
@@ -0,0 +1,163 @@
+#include <abel/FileCopy.hpp>
+
+#include <abel/Error.hpp>
+
+#include <memory>
+#include <algorithm>
+#include <exception>
+
+namespace abel {
+
+namespace {
+
+struct copy_slot {
+    // Declared first so that it outlives the operation, which gets cancelled and waited for on destruction
+    std::unique_ptr<unsigned char[]> buf{};
+    PendingIO op{};
+    uint64_t offset = 0;
+    size_t length = 0;
+    // How much of the chunk has been read or written so far
+    size_t done = 0;
+    bool writing = false;
+    bool active = false;
+};
+
+// ParallelAIOs swallows task exceptions, so they have to be carried out explicitly
+AIO<void> store_result(AIO<copy_progress> task, copy_progress &result, std::exception_ptr &error) {
+    try {
+        result = co_await task;
+    } catch (...) {
+        error = std::current_exception();
+    }
+}
+
+}  // namespace
+
+AIO<copy_progress> copy_file_async(Handle src, Handle dst, copy_options options) {
+    constexpr size_t chunk_alignment = 64 * 1024;
+
+    size_t chunk_size = std::max<size_t>(options.chunk_size, 1);
+    chunk_size = (chunk_size + chunk_alignment - 1) / chunk_alignment * chunk_alignment;
+    size_t depth = std::max<size_t>(options.depth, 1);
+
+    auto start = aio_clock::now();
+
+    copy_progress progress{};
+    progress.total_bytes = src.file_size();
+
+    if (options.preallocate) {
+        dst.preallocate(progress.total_bytes);
+    }
+
+    // If anything throws, the slot destructors cancel whatever is still in flight
+    auto slots = std::make_unique<copy_slot[]>(depth);
+    uint64_t next_offset = 0;
+    size_t active = 0;
+
+    auto start_read = [&](copy_slot &slot) {
+        slot.offset = next_offset;
+        slot.length = (size_t)std::min<uint64_t>(chunk_size, progress.total_bytes - next_offset);
+        slot.done = 0;
+        slot.writing = false;
+        slot.active = true;
+        next_offset += slot.length;
+
+        if (!src.begin_read_at(slot.op, slot.offset, {slot.buf.get(), slot.length})) {
+            fail("Source file ended prematurely");
+        }
+    };
+
+    for (size_t i = 0; i < depth && next_offset < progress.total_bytes; ++i) {
+        slots[i].buf = std::make_unique_for_overwrite<unsigned char[]>(chunk_size);
+        start_read(slots[i]);
+        ++active;
+    }
+
+    // Chunks are issued in order and mostly complete in order, so waiting on them round-robin
+    // keeps every slot busy without needing to wait on several events at once
+    for (size_t i = 0; active > 0; i = (i + 1) % depth) {
+        copy_slot &slot = slots[i];
+        if (!slot.active) {
+            continue;
+        }
+
+        co_await event_signaled{slot.op.event_done()};
+        eof<size_t> result = slot.op.result();
+
+        if (result.value == 0) {
+            fail(slot.writing ? "Failed to write to destination file" : "Source file ended prematurely");
+        }
+
+        slot.done += result.value;
+        std::span<unsigned char> rest{slot.buf.get() + slot.done, slot.length - slot.done};
+
+        if (!slot.writing) {
+            if (!rest.empty()) {
+                if (!src.begin_read_at(slot.op, slot.offset + slot.done, rest)) {
+                    fail("Source file ended prematurely");
+                }
+                continue;
+            }
+
+            slot.done = 0;
+            slot.writing = true;
+            dst.begin_write_at(slot.op, slot.offset, {slot.buf.get(), slot.length});
+            continue;
+        }
+
+        if (!rest.empty()) {
+            dst.begin_write_at(slot.op, slot.offset + slot.done, rest);
+            continue;
+        }
+
+        progress.copied_bytes += slot.length;
+        progress.elapsed = aio_clock::now() - start;
+        if (options.on_progress) {
+            options.on_progress(progress);
+        }
+
+        if (next_offset < progress.total_bytes) {
+            start_read(slot);
+        } else {
+            slot.active = false;
+            --active;
+        }
+    }
+
+    // Also truncates whatever the destination held before
+    dst.set_file_size(progress.total_bytes);
+
+    progress.elapsed = aio_clock::now() - start;
+    co_return progress;
+}
+
+copy_progress copy_file(const std::string &src, const std::string &dst, copy_options options) {
+    OwningHandle src_file = Handle::open_file(
+        src,
+        GENERIC_READ,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN
+    );
+
+    OwningHandle dst_file = Handle::open_file(
+        dst,
+        GENERIC_WRITE,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+        0
+    );
+
+    copy_progress result{};
+    std::exception_ptr error = nullptr;
+
+    ParallelAIOs tasks(store_result(copy_file_async(src_file, dst_file, std::move(options)), result, error));
+    tasks.run();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    return result;
+}
+
+}  // namespace abel
@@ -3,10 +3,18 @@
 #include <abel/Error.hpp>
 #include <abel/Concurrency.hpp>
 #include <abel/RemotePtr.hpp>
+#include <abel/IOPool.hpp>
+
+#include <winternl.h>
 
 namespace abel {
 
+void Handle::forget_synchronous(HANDLE value) noexcept {
+    BlockingIOPool::unregister(value);
+}
+
 void Handle::close() {
+    forget_synchronous(value);
     bool success = CloseHandle(value);
     value = NULL;
 
@@ -32,6 +40,11 @@ OwningHandle Handle::clone() const {
         fail("Failed to duplicate handle");
     }
 
+    // Refers to the same file object, so it is just as synchronous
+    if (BlockingIOPool::is_registered(*this)) {
+        BlockingIOPool::register_synchronous(result);
+    }
+
     return result;
 }
 
@@ -58,11 +71,41 @@ eof<size_t> Handle::write_from(std::span<const unsigned char> data) {
     return eof((size_t)written, written == 0);
 }
 
+bool Handle::is_synchronous() const {
+    using query_t = LONG(NTAPI *)(HANDLE, IO_STATUS_BLOCK *, void *, ULONG, FILE_INFORMATION_CLASS);
+
+    // Not exposed by the Win32 API, so it has to be queried from ntdll directly
+    static const query_t query = (query_t)GetProcAddress(GetModuleHandleA("ntdll.dll"), "NtQueryInformationFile");
+
+    constexpr ULONG file_mode_information = 16;
+    constexpr ULONG file_synchronous_io_alert = 0x10;
+    constexpr ULONG file_synchronous_io_nonalert = 0x20;
+
+    if (!query) {
+        return false;
+    }
+
+    IO_STATUS_BLOCK status_block{};
+    ULONG mode = 0;
+    LONG status = query(raw(), &status_block, &mode, sizeof(mode), (FILE_INFORMATION_CLASS)file_mode_information);
+
+    if (status < 0) {
+        // Not a file object (e.g. a console handle on older systems), so nothing we could offload anyway
+        return false;
+    }
+
+    return (mode & (file_synchronous_io_alert | file_synchronous_io_nonalert)) != 0;
+}
+
 void Handle::cancel_async() {
     CancelIo(raw());
 }
 
 AIO<eof<size_t>> Handle::read_async_into(std::span<unsigned char> data) {
+    if (BlockingIOPool::is_registered(*this)) {
+        co_return co_await BlockingIOPool::instance().read_async(*this, data);
+    }
+
     auto &env = *co_await current_env{};
     OVERLAPPED *overlapped = env.overlapped();
 
@@ -98,6 +141,10 @@ AIO<eof<size_t>> Handle::read_async_into(std::span<unsigned char> data) {
 }
 
 AIO<eof<size_t>> Handle::write_async_from(std::span<const unsigned char> data) {
+    if (BlockingIOPool::is_registered(*this)) {
+        co_return co_await BlockingIOPool::instance().write_async(*this, data);
+    }
+
     auto &env = *co_await current_env{};
     OVERLAPPED *overlapped = env.overlapped();
 
@@ -131,8 +178,252 @@ AIO<eof<size_t>> Handle::write_async_from(std::span<const unsigned char> data) {
     // TODO: Perhaps a GetLastError check is necessary instead?
     co_return eof((size_t)transmitted, transmitted == 0);
 }
+
+eof<size_t> Handle::read_at(uint64_t offset, std::span<unsigned char> data) {
+    PendingIO op{};
+    if (!begin_read_at(op, offset, data)) {
+        return eof((size_t)0, true);
+    }
+    return op.result();
+}
+
+eof<size_t> Handle::write_at(uint64_t offset, std::span<const unsigned char> data) {
+    PendingIO op{};
+    begin_write_at(op, offset, data);
+    return op.result();
+}
+
+bool Handle::begin_read_at(PendingIO &op, uint64_t offset, std::span<unsigned char> data) {
+    bool success = ReadFile(
+        raw(),
+        data.data(),
+        (DWORD)data.size(),
+        nullptr,
+        op.prepare(*this, offset)
+    );
+
+    if (!success) {
+        switch (GetLastError()) {
+        case ERROR_IO_PENDING:
+            break;
+        case ERROR_HANDLE_EOF:
+            return false;
+        default:
+            fail("Failed to initiate positional read from handle");
+        }
+    }
+
+    return true;
+}
+
+void Handle::begin_write_at(PendingIO &op, uint64_t offset, std::span<const unsigned char> data) {
+    bool success = WriteFile(
+        raw(),
+        data.data(),
+        (DWORD)data.size(),
+        nullptr,
+        op.prepare(*this, offset)
+    );
+
+    if (!success && GetLastError() != ERROR_IO_PENDING) {
+        fail("Failed to initiate positional write to handle");
+    }
+}
+
+AIO<eof<size_t>> Handle::read_async_at(uint64_t offset, std::span<unsigned char> data) {
+    if (BlockingIOPool::is_registered(*this)) {
+        co_return co_await BlockingIOPool::instance().read_async_at(*this, offset, data);
+    }
+
+    auto &env = *co_await current_env{};
+    OVERLAPPED *overlapped = env.overlapped(offset);
+
+    bool success = ReadFile(
+        raw(),
+        data.data(),
+        (DWORD)data.size(),
+        nullptr,
+        overlapped
+    );
+
+    if (!success) {
+        switch (GetLastError()) {
+        case ERROR_IO_PENDING:
+            break;
+        case ERROR_HANDLE_EOF:
+            co_return eof((size_t)0, true);
+        default:
+            fail("Failed to initiate asynchronous positional read from handle");
+        }
+    }
+
+    co_await io_done_signaled{};
+
+    DWORD transmitted = 0;
+    success = GetOverlappedResultEx(
+        raw(),
+        overlapped,
+        &transmitted,
+        0,
+        false
+    );
+
+    if (!success) {
+        if (GetLastError() == ERROR_HANDLE_EOF) {
+            co_return eof((size_t)transmitted, true);
+        }
+        fail("Failed to get overlapped operation result");
+    }
+
+    co_return eof((size_t)transmitted, transmitted == 0);
+}
+
+AIO<eof<size_t>> Handle::write_async_at(uint64_t offset, std::span<const unsigned char> data) {
+    if (BlockingIOPool::is_registered(*this)) {
+        co_return co_await BlockingIOPool::instance().write_async_at(*this, offset, data);
+    }
+
+    auto &env = *co_await current_env{};
+    OVERLAPPED *overlapped = env.overlapped(offset);
+
+    bool success = WriteFile(
+        raw(),
+        data.data(),
+        (DWORD)data.size(),
+        nullptr,
+        overlapped
+    );
+
+    if (!success && GetLastError() != ERROR_IO_PENDING) {
+        fail("Failed to initiate asynchronous positional write to handle");
+    }
+
+    co_await io_done_signaled{};
+
+    DWORD transmitted = 0;
+    success = GetOverlappedResultEx(
+        raw(),
+        overlapped,
+        &transmitted,
+        0,
+        false
+    );
+
+    if (!success) {
+        fail("Failed to get overlapped operation result");
+    }
+
+    co_return eof((size_t)transmitted, transmitted == 0);
+}
+
+AIO<std::vector<eof<size_t>>> Handle::read_async_many_at(std::span<const read_request> requests) {
+    // If anything throws, the destructors cancel whatever is still in flight
+    auto ops = std::make_unique<PendingIO[]>(requests.size());
+    std::vector<bool> started(requests.size(), false);
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        started[i] = begin_read_at(ops[i], requests[i].offset, requests[i].data);
+    }
+
+    std::vector<eof<size_t>> results(requests.size(), eof<size_t>{0, true});
+
+    // All the reads are already running, so waiting for them in order costs nothing extra
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (!started[i]) {
+            continue;
+        }
+        co_await event_signaled{ops[i].event_done()};
+        results[i] = ops[i].result();
+    }
+
+    co_return results;
+}
+
+AIO<std::vector<eof<size_t>>> Handle::write_async_many_at(std::span<const write_request> requests) {
+    // If anything throws, the destructors cancel whatever is still in flight
+    auto ops = std::make_unique<PendingIO[]>(requests.size());
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        begin_write_at(ops[i], requests[i].offset, requests[i].data);
+    }
+
+    std::vector<eof<size_t>> results(requests.size(), eof<size_t>{0, true});
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        co_await event_signaled{ops[i].event_done()};
+        results[i] = ops[i].result();
+    }
+
+    co_return results;
+}
 #pragma endregion IO
 
+#pragma region File
+OwningHandle Handle::open_file(
+    const std::string &path,
+    DWORD access,
+    DWORD creationDisposition,
+    DWORD flags,
+    DWORD shareMode,
+    bool inheritHandle
+) {
+    SECURITY_ATTRIBUTES sa{
+        .nLength = sizeof(SECURITY_ATTRIBUTES),
+        .lpSecurityDescriptor = nullptr,
+        .bInheritHandle = inheritHandle,
+    };
+
+    OwningHandle result = OwningHandle(CreateFileA(
+        path.c_str(),
+        access,
+        shareMode,
+        &sa,
+        creationDisposition,
+        flags,
+        NULL
+    )).validate();
+
+    if (!(flags & FILE_FLAG_OVERLAPPED)) {
+        BlockingIOPool::register_synchronous(result);
+    }
+
+    return result;
+}
+
+uint64_t Handle::file_size() const {
+    LARGE_INTEGER result{};
+    bool success = GetFileSizeEx(raw(), &result);
+
+    if (!success) {
+        fail("Failed to get file size");
+    }
+
+    return (uint64_t)result.QuadPart;
+}
+
+void Handle::set_file_size(uint64_t size) {
+    FILE_END_OF_FILE_INFO info{};
+    info.EndOfFile.QuadPart = (LONGLONG)size;
+
+    bool success = SetFileInformationByHandle(raw(), FileEndOfFileInfo, &info, sizeof(info));
+
+    if (!success) {
+        fail("Failed to set file size");
+    }
+}
+
+void Handle::preallocate(uint64_t size) {
+    FILE_ALLOCATION_INFO info{};
+    info.AllocationSize.QuadPart = (LONGLONG)size;
+
+    bool success = SetFileInformationByHandle(raw(), FileAllocationInfo, &info, sizeof(info));
+
+    if (!success) {
+        fail("Failed to preallocate file");
+    }
+}
+#pragma endregion File
+
 #pragma region Synchronization
 OwningHandle Handle::create_event(bool manualReset, bool initialState, bool inheritHandle) {
     SECURITY_ATTRIBUTES sa{
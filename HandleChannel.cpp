@@ -0,0 +1,316 @@
+#include <abel/HandleChannel.hpp>
+
+#include <abel/Process.hpp>
+
+#include <afunix.h>
+#include <cstring>
+#include <algorithm>
+
+namespace abel {
+
+#pragma region HandleChannel
+// A sanity limit, so that a corrupted header doesn't make us allocate gigabytes
+static constexpr uint32_t _impl_max_handles_per_message = 1024;
+
+HandleChannel::HandleChannel(Socket channel_) :
+    channel{channel_} {
+
+    channel.validate();
+
+    DWORD returned = 0;
+    int status = WSAIoctl(
+        channel.raw(),
+        SIO_AF_UNIX_GETPEERPID,
+        nullptr,
+        0,
+        &peer_pid_,
+        sizeof(peer_pid_),
+        &returned,
+        nullptr,
+        nullptr
+    );
+    if (status == SOCKET_ERROR) {
+        fail_ws("Failed to get peer process id of local socket");
+    }
+}
+
+std::vector<unsigned char> HandleChannel::encode_sockets(std::span<const Socket> sockets) {
+    if (sockets.size() > _impl_max_handles_per_message) {
+        fail("Too many sockets in one message");
+    }
+
+    header hdr{handle_message_kind::sockets, (uint32_t)sockets.size()};
+    std::vector<unsigned char> result(sizeof(hdr) + sockets.size() * sizeof(WSAPROTOCOL_INFOW));
+    std::memcpy(result.data(), &hdr, sizeof(hdr));
+
+    for (size_t i = 0; i < sockets.size(); ++i) {
+        WSAPROTOCOL_INFOW info{};
+        int status = WSADuplicateSocketW(sockets[i].raw(), peer_pid_, &info);
+        if (status == SOCKET_ERROR) {
+            fail_ws("Failed to duplicate socket for peer process");
+        }
+
+        std::memcpy(result.data() + sizeof(hdr) + i * sizeof(info), &info, sizeof(info));
+    }
+
+    return result;
+}
+
+std::vector<unsigned char> HandleChannel::encode_handles(std::span<const Handle> handles) {
+    if (handles.size() > _impl_max_handles_per_message) {
+        fail("Too many handles in one message");
+    }
+
+    if (!peer_process) {
+        peer_process = Process::open(peer_pid_, PROCESS_DUP_HANDLE);
+    }
+
+    header hdr{handle_message_kind::handles, (uint32_t)handles.size()};
+    std::vector<unsigned char> result(sizeof(hdr) + handles.size() * sizeof(uint64_t));
+    std::memcpy(result.data(), &hdr, sizeof(hdr));
+
+    for (size_t i = 0; i < handles.size(); ++i) {
+        HANDLE remote = nullptr;
+        bool success = DuplicateHandle(
+            GetCurrentProcess(),
+            handles[i].raw(),
+            peer_process.raw(),
+            &remote,
+            0,
+            false,
+            DUPLICATE_SAME_ACCESS
+        );
+        if (!success) {
+            fail("Failed to duplicate handle into peer process");
+        }
+
+        // Handle values are 32-bit significant even in 64-bit processes, but keep the full width anyway
+        uint64_t value = (uint64_t)(uintptr_t)remote;
+        std::memcpy(result.data() + sizeof(hdr) + i * sizeof(value), &value, sizeof(value));
+    }
+
+    return result;
+}
+
+std::vector<unsigned char> HandleChannel::encode_load(uint64_t active) {
+    header hdr{handle_message_kind::load, 0};
+    load_report report{.active = active, .received = received_sockets};
+
+    std::vector<unsigned char> result(sizeof(hdr) + sizeof(report));
+    std::memcpy(result.data(), &hdr, sizeof(hdr));
+    std::memcpy(result.data() + sizeof(hdr), &report, sizeof(report));
+
+    return result;
+}
+
+size_t HandleChannel::payload_size(const header &hdr) {
+    if (hdr.count > _impl_max_handles_per_message) {
+        fail("Too many handles in one message");
+    }
+
+    switch (hdr.kind) {
+    case handle_message_kind::sockets:
+        return hdr.count * sizeof(WSAPROTOCOL_INFOW);
+    case handle_message_kind::handles:
+        return hdr.count * sizeof(uint64_t);
+    case handle_message_kind::load:
+        return sizeof(load_report);
+    default:
+        fail("Unknown handle message kind");
+    }
+}
+
+handle_message HandleChannel::decode(const header &hdr, std::span<const unsigned char> payload) {
+    handle_message result{.kind = hdr.kind};
+
+    switch (hdr.kind) {
+    case handle_message_kind::sockets: {
+        for (size_t i = 0; i < hdr.count; ++i) {
+            WSAPROTOCOL_INFOW info{};
+            std::memcpy(&info, payload.data() + i * sizeof(info), sizeof(info));
+
+            result.sockets.push_back(OwningSocket(
+                WSASocketW(
+                    FROM_PROTOCOL_INFO,
+                    FROM_PROTOCOL_INFO,
+                    FROM_PROTOCOL_INFO,
+                    &info,
+                    0,
+                    WSA_FLAG_OVERLAPPED | WSA_FLAG_NO_HANDLE_INHERIT
+                )
+            ).validate());
+        }
+        received_sockets += hdr.count;
+    } break;
+
+    case handle_message_kind::handles: {
+        for (size_t i = 0; i < hdr.count; ++i) {
+            uint64_t value = 0;
+            std::memcpy(&value, payload.data() + i * sizeof(value), sizeof(value));
+            result.handles.push_back(OwningHandle((HANDLE)(uintptr_t)value));
+        }
+    } break;
+
+    case handle_message_kind::load: {
+        std::memcpy(&result.load, payload.data(), sizeof(result.load));
+    } break;
+    }
+
+    return result;
+}
+
+void HandleChannel::send_sockets(std::span<const Socket> sockets) {
+    channel.write_full_from(encode_sockets(sockets));
+}
+
+AIO<void> HandleChannel::send_sockets_async(std::span<const Socket> sockets) {
+    std::vector<unsigned char> message = encode_sockets(sockets);
+    co_await channel.write_async_full_from(message);
+}
+
+void HandleChannel::send_handles(std::span<const Handle> handles) {
+    channel.write_full_from(encode_handles(handles));
+}
+
+AIO<void> HandleChannel::send_handles_async(std::span<const Handle> handles) {
+    std::vector<unsigned char> message = encode_handles(handles);
+    co_await channel.write_async_full_from(message);
+}
+
+void HandleChannel::send_load(uint64_t active) {
+    channel.write_full_from(encode_load(active));
+}
+
+AIO<void> HandleChannel::send_load_async(uint64_t active) {
+    std::vector<unsigned char> message = encode_load(active);
+    co_await channel.write_async_full_from(message);
+}
+
+eof<handle_message> HandleChannel::recv() {
+    header hdr{};
+    std::span<unsigned char> hdr_bytes{(unsigned char *)&hdr, sizeof(hdr)};
+
+    // A clean eof is only acceptable between messages
+    eof<size_t> first = channel.read_into(hdr_bytes);
+    if (first.is_eof && first.value == 0) {
+        return eof<handle_message>{handle_message{}, true};
+    }
+    channel.read_full_into(hdr_bytes.subspan(first.value));
+
+    std::vector<unsigned char> payload(payload_size(hdr));
+    channel.read_full_into(payload);
+
+    return eof<handle_message>{decode(hdr, payload), false};
+}
+
+AIO<eof<handle_message>> HandleChannel::recv_async() {
+    auto hdr = std::make_unique<header>();
+    std::span<unsigned char> hdr_bytes{(unsigned char *)hdr.get(), sizeof(header)};
+
+    // A clean eof is only acceptable between messages
+    eof<size_t> first = co_await channel.read_async_into(hdr_bytes);
+    if (first.is_eof && first.value == 0) {
+        co_return eof<handle_message>{handle_message{}, true};
+    }
+    co_await channel.read_async_full_into(hdr_bytes.subspan(first.value));
+
+    std::vector<unsigned char> payload(payload_size(*hdr));
+    co_await channel.read_async_full_into(payload);
+
+    co_return eof<handle_message>{decode(*hdr, payload), false};
+}
+#pragma endregion HandleChannel
+
+#pragma region ConnectionDispatcher
+size_t ConnectionDispatcher::add_worker(Socket channel) {
+    workers.push_back(std::make_unique<worker>(worker{HandleChannel(channel)}));
+    return workers.size() - 1;
+}
+
+size_t ConnectionDispatcher::pick() {
+    size_t result = workers.size();
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+        if (!workers[i]->alive) {
+            continue;
+        }
+        if (result == workers.size() || workers[i]->estimated_load() < workers[result]->estimated_load()) {
+            result = i;
+        }
+    }
+
+    if (result == workers.size()) {
+        fail("No workers to dispatch connections to");
+    }
+
+    return result;
+}
+
+void ConnectionDispatcher::record_handoff(aio_clock::time_point start) noexcept {
+    aio_clock::duration handoff = aio_clock::now() - start;
+    ++stats_.dispatched;
+    stats_.total_handoff += handoff;
+    stats_.max_handoff = std::max<aio_clock::duration>(stats_.max_handoff, handoff);
+}
+
+size_t ConnectionDispatcher::dispatch(OwningSocket connection) {
+    aio_clock::time_point start = aio_clock::now();
+
+    size_t idx = pick();
+    worker &target = *workers[idx];
+
+    Socket sockets[1]{connection.borrow()};
+    try {
+        target.channel.send_sockets(sockets);
+    } catch (...) {
+        // Most likely the worker is gone
+        target.alive = false;
+        throw;
+    }
+
+    ++target.dispatched;
+    record_handoff(start);
+    return idx;
+}
+
+AIO<size_t> ConnectionDispatcher::dispatch_async(OwningSocket connection) {
+    aio_clock::time_point start = aio_clock::now();
+
+    size_t idx = pick();
+    worker &target = *workers[idx];
+    // Counted upfront, so that concurrent dispatches see it
+    ++target.dispatched;
+
+    Socket sockets[1]{connection.borrow()};
+    try {
+        co_await target.channel.send_sockets_async(sockets);
+    } catch (...) {
+        // Most likely the worker is gone
+        --target.dispatched;
+        target.alive = false;
+        throw;
+    }
+
+    record_handoff(start);
+    co_return idx;
+}
+
+AIO<void> ConnectionDispatcher::monitor(size_t idx) {
+    worker &target = *workers[idx];
+
+    while (true) {
+        eof<handle_message> message = co_await target.channel.recv_async();
+        if (message.is_eof) {
+            break;
+        }
+
+        if (message.value.kind == handle_message_kind::load) {
+            target.last_report = message.value.load;
+        }
+    }
+
+    target.alive = false;
+}
+#pragma endregion ConnectionDispatcher
+
+}  // namespace abel
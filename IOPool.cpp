@@ -0,0 +1,195 @@
+#include <abel/IOPool.hpp>
+
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <shared_mutex>
+#include <unordered_set>
+
+namespace abel {
+
+// Synchronous handles, see BlockingIOPool::register_synchronous
+static std::shared_mutex registry_mutex{};
+static std::unordered_set<HANDLE> registry{};
+// Lets the common case of nothing being registered skip the lock
+static std::atomic<size_t> registry_size{0};
+
+struct BlockingIOPool::job {
+    BlockingIOPool *owner = nullptr;
+    Handle handle = nullptr;
+    std::span<unsigned char> read_buf{};
+    std::span<const unsigned char> write_buf{};
+    bool is_write = false;
+    std::optional<uint64_t> offset{};
+
+    eof<size_t> result{0, false};
+    std::exception_ptr error = nullptr;
+    OwningHandle done = Handle::create_event(true, false);
+    aio_clock::time_point submitted{};
+};
+
+BlockingIOPool::BlockingIOPool(size_t max_threads) {
+    pool = CreateThreadpool(nullptr);
+    if (!pool) {
+        fail("Failed to create thread pool");
+    }
+
+    SetThreadpoolThreadMaximum(pool, (DWORD)std::max<size_t>(max_threads, 1));
+
+    cleanup = CreateThreadpoolCleanupGroup();
+    if (!cleanup) {
+        CloseThreadpool(pool);
+        fail("Failed to create thread pool cleanup group");
+    }
+
+    InitializeThreadpoolEnvironment(&environ_);
+    SetThreadpoolCallbackPool(&environ_, pool);
+    SetThreadpoolCallbackCleanupGroup(&environ_, cleanup, nullptr);
+    // Our callbacks block on IO by design
+    SetThreadpoolCallbackRunsLong(&environ_);
+}
+
+BlockingIOPool::~BlockingIOPool() noexcept {
+    CloseThreadpoolCleanupGroupMembers(cleanup, true, nullptr);
+    CloseThreadpoolCleanupGroup(cleanup);
+    DestroyThreadpoolEnvironment(&environ_);
+    CloseThreadpool(pool);
+}
+
+BlockingIOPool &BlockingIOPool::instance() {
+    static BlockingIOPool *result = new BlockingIOPool();
+    return *result;
+}
+
+void CALLBACK BlockingIOPool::run_job(PTP_CALLBACK_INSTANCE, void *context) {
+    // Takes over the reference made at submission
+    std::unique_ptr<std::shared_ptr<job>> holder{(std::shared_ptr<job> *)context};
+    job &task = **holder;
+    BlockingIOPool &owner = *task.owner;
+
+    --owner.queued;
+    ++owner.running;
+
+    try {
+        if (task.offset) {
+            if (task.is_write) {
+                task.result = task.handle.write_at(*task.offset, task.write_buf);
+            } else {
+                task.result = task.handle.read_at(*task.offset, task.read_buf);
+            }
+        } else if (task.is_write) {
+            task.result = task.handle.write_from(task.write_buf);
+        } else {
+            task.result = task.handle.read_into(task.read_buf);
+        }
+    } catch (...) {
+        task.error = std::current_exception();
+    }
+
+    int64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(aio_clock::now() - task.submitted).count();
+    owner.total_latency_ns += latency;
+    int64_t prev_max = owner.max_latency_ns.load();
+    while (latency > prev_max && !owner.max_latency_ns.compare_exchange_weak(prev_max, latency)) {
+    }
+
+    --owner.running;
+    ++owner.completed;
+
+    task.done.signal();
+}
+
+AIO<eof<size_t>> BlockingIOPool::submit(std::shared_ptr<job> task) {
+    task->owner = this;
+    task->submitted = aio_clock::now();
+
+    auto context = std::make_unique<std::shared_ptr<job>>(task);
+
+    ++queued;
+    bool success = TrySubmitThreadpoolCallback(&run_job, context.get(), &environ_);
+    if (!success) {
+        --queued;
+        fail_ec("Failed to submit blocking IO to the thread pool");
+    }
+    // The callback owns it now
+    context.release();
+
+    co_await event_signaled{task->done};
+
+    if (task->error) {
+        std::rethrow_exception(task->error);
+    }
+
+    co_return task->result;
+}
+
+AIO<eof<size_t>> BlockingIOPool::read_async(Handle handle, std::span<unsigned char> data) {
+    auto task = std::make_shared<job>();
+    task->handle = handle;
+    task->read_buf = data;
+    return submit(std::move(task));
+}
+
+AIO<eof<size_t>> BlockingIOPool::write_async(Handle handle, std::span<const unsigned char> data) {
+    auto task = std::make_shared<job>();
+    task->handle = handle;
+    task->write_buf = data;
+    task->is_write = true;
+    return submit(std::move(task));
+}
+
+AIO<eof<size_t>> BlockingIOPool::read_async_at(Handle handle, uint64_t offset, std::span<unsigned char> data) {
+    auto task = std::make_shared<job>();
+    task->handle = handle;
+    task->read_buf = data;
+    task->offset = offset;
+    return submit(std::move(task));
+}
+
+AIO<eof<size_t>> BlockingIOPool::write_async_at(Handle handle, uint64_t offset, std::span<const unsigned char> data) {
+    auto task = std::make_shared<job>();
+    task->handle = handle;
+    task->write_buf = data;
+    task->is_write = true;
+    task->offset = offset;
+    return submit(std::move(task));
+}
+
+io_pool_stats BlockingIOPool::stats() const noexcept {
+    return io_pool_stats{
+        .queued = queued.load(),
+        .running = running.load(),
+        .completed = completed.load(),
+        .total_latency = std::chrono::duration_cast<aio_clock::duration>(std::chrono::nanoseconds(total_latency_ns.load())),
+        .max_latency = std::chrono::duration_cast<aio_clock::duration>(std::chrono::nanoseconds(max_latency_ns.load())),
+    };
+}
+
+void BlockingIOPool::register_synchronous(Handle handle) {
+    std::unique_lock lock{registry_mutex};
+    if (registry.insert(handle.raw()).second) {
+        ++registry_size;
+    }
+}
+
+void BlockingIOPool::unregister(Handle handle) noexcept {
+    if (registry_size.load() == 0) {
+        return;
+    }
+
+    std::unique_lock lock{registry_mutex};
+    if (registry.erase(handle.raw())) {
+        --registry_size;
+    }
+}
+
+bool BlockingIOPool::is_registered(Handle handle) noexcept {
+    if (registry_size.load() == 0) {
+        return false;
+    }
+
+    std::shared_lock lock{registry_mutex};
+    return registry.contains(handle.raw());
+}
+
+}  // namespace abel
@@ -0,0 +1,173 @@
+#include <abel/MappedFile.hpp>
+
+#include <cstring>
+
+namespace abel {
+
+static size_t allocation_granularity() noexcept {
+    static const size_t result = [] {
+        SYSTEM_INFO info{};
+        GetSystemInfo(&info);
+        return (size_t)info.dwAllocationGranularity;
+    }();
+    return result;
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept :
+    MappedFile() {
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    std::swap(mapping, other.mapping);
+    std::swap(size_, other.size_);
+    std::swap(window_size, other.window_size);
+    std::swap(hint, other.hint);
+    std::swap(view_, other.view_);
+    std::swap(view_offset, other.view_offset);
+    std::swap(view_size, other.view_size);
+    std::swap(position, other.position);
+    return *this;
+}
+
+MappedFile::~MappedFile() noexcept {
+    unmap();
+}
+
+MappedFile MappedFile::open(Handle file, size_t window_size, access_hint hint) {
+    MappedFile result{};
+
+    size_t granularity = allocation_granularity();
+    window_size = std::max<size_t>(window_size, 1);
+    result.window_size = (window_size + granularity - 1) / granularity * granularity;
+    result.hint = hint;
+    result.size_ = file.file_size();
+
+    if (result.size_ == 0) {
+        // Empty files cannot be mapped, but there is nothing to map anyway
+        return result;
+    }
+
+    result.mapping = OwningHandle(CreateFileMappingA(
+        file.raw(),
+        nullptr,
+        PAGE_READONLY,
+        0,
+        0,
+        nullptr
+    )).validate();
+
+    return result;
+}
+
+MappedFile MappedFile::open(const std::string &path, size_t window_size, access_hint hint) {
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (hint == access_hint::sequential) {
+        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    } else if (hint == access_hint::random) {
+        flags |= FILE_FLAG_RANDOM_ACCESS;
+    }
+
+    OwningHandle file = Handle::open_file(path, GENERIC_READ, OPEN_EXISTING, flags);
+    return open(file, window_size, hint);
+}
+
+void MappedFile::unmap() noexcept {
+    if (view_) {
+        UnmapViewOfFile(view_);
+        view_ = nullptr;
+        view_offset = 0;
+        view_size = 0;
+    }
+}
+
+void MappedFile::map(uint64_t offset, size_t length) {
+    if (view_ && offset >= view_offset && offset + length <= view_offset + view_size) {
+        return;
+    }
+
+    uint64_t aligned = offset - offset % allocation_granularity();
+    if (offset - aligned + length > window_size) {
+        fail("Requested range does not fit in the mapping window");
+    }
+
+    unmap();
+
+    size_t map_size = (size_t)std::min<uint64_t>(window_size, size_ - aligned);
+
+    void *result = MapViewOfFile(
+        mapping.raw(),
+        FILE_MAP_READ,
+        (DWORD)(aligned >> 32),
+        (DWORD)(aligned & 0xFFFFFFFF),
+        map_size
+    );
+
+    if (!result) {
+        fail("Failed to map view of file");
+    }
+
+    view_ = (const unsigned char *)result;
+    view_offset = aligned;
+    view_size = map_size;
+
+    if (hint == access_hint::sequential) {
+        // Just a hint, so failures are fine to ignore
+        WIN32_MEMORY_RANGE_ENTRY range{
+            .VirtualAddress = result,
+            .NumberOfBytes = map_size,
+        };
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+}
+
+std::span<const unsigned char> MappedFile::view(uint64_t offset, size_t length) {
+    if (offset >= size_) {
+        return {};
+    }
+
+    length = (size_t)std::min<uint64_t>(length, size_ - offset);
+    map(offset, length);
+
+    return {view_ + (offset - view_offset), length};
+}
+
+std::span<const unsigned char> MappedFile::next(size_t max_length) {
+    if (position >= size_ || max_length == 0) {
+        return {};
+    }
+
+    map(position, 1);
+
+    size_t length = (size_t)std::min<uint64_t>(max_length, view_offset + view_size - position);
+    std::span<const unsigned char> result{view_ + (position - view_offset), length};
+    position += length;
+
+    return result;
+}
+
+void MappedFile::seek(uint64_t offset) {
+    if (offset > size_) {
+        fail("Seek beyond the end of the mapped file");
+    }
+
+    position = offset;
+}
+
+eof<size_t> MappedFile::read_into(std::span<unsigned char> data) {
+    size_t read = 0;
+
+    while (read < data.size()) {
+        auto chunk = next(data.size() - read);
+        if (chunk.empty()) {
+            break;
+        }
+
+        std::memcpy(data.data() + read, chunk.data(), chunk.size());
+        read += chunk.size();
+    }
+
+    return eof(read, read == 0);
+}
+
+}  // namespace abel
@@ -0,0 +1,174 @@
+#include <abel/MemoryStream.hpp>
+
+#include <cstring>
+
+namespace abel {
+
+#pragma region MemoryQueue
+MemoryQueue::MemoryQueue(size_t capacity) :
+    storage(capacity) {
+
+    if (capacity == 0) {
+        fail("Memory queue capacity must be positive");
+    }
+}
+
+// Must be called with the mutex held
+void MemoryQueue::update_events() {
+    if (used > 0 || write_closed) {
+        readable_.signal();
+    } else {
+        readable_.reset();
+    }
+
+    if (used < storage.size() || read_closed) {
+        writable_.signal();
+    } else {
+        writable_.reset();
+    }
+}
+
+eof<size_t> MemoryQueue::try_read(std::span<unsigned char> data) {
+    std::lock_guard lock{mutex};
+
+    if (used == 0) {
+        return eof((size_t)0, write_closed);
+    }
+
+    bool was_full = used == storage.size();
+
+    size_t total = std::min<size_t>(data.size(), used);
+    size_t first = std::min<size_t>(total, storage.size() - head);
+    std::memcpy(data.data(), storage.data() + head, first);
+    std::memcpy(data.data() + first, storage.data(), total - first);
+
+    head = (head + total) % storage.size();
+    used -= total;
+
+    if (was_full || used == 0) {
+        update_events();
+    }
+
+    return eof(total, false);
+}
+
+eof<size_t> MemoryQueue::try_write(std::span<const unsigned char> data) {
+    std::lock_guard lock{mutex};
+
+    if (read_closed) {
+        return eof((size_t)0, true);
+    }
+
+    if (used == storage.size()) {
+        return eof((size_t)0, false);
+    }
+
+    bool was_empty = used == 0;
+
+    size_t total = std::min<size_t>(data.size(), storage.size() - used);
+    size_t tail = (head + used) % storage.size();
+    size_t first = std::min<size_t>(total, storage.size() - tail);
+    std::memcpy(storage.data() + tail, data.data(), first);
+    std::memcpy(storage.data(), data.data() + first, total - first);
+
+    used += total;
+
+    if (was_empty || used == storage.size()) {
+        update_events();
+    }
+
+    return eof(total, false);
+}
+
+void MemoryQueue::close_write() {
+    std::lock_guard lock{mutex};
+    write_closed = true;
+    update_events();
+}
+
+void MemoryQueue::close_read() {
+    std::lock_guard lock{mutex};
+    read_closed = true;
+    update_events();
+}
+
+size_t MemoryQueue::size() const {
+    std::lock_guard lock{mutex};
+    return used;
+}
+#pragma endregion MemoryQueue
+
+#pragma region MemoryStream
+std::pair<MemoryStream, MemoryStream> MemoryStream::create_pair(size_t capacity) {
+    auto forward = std::make_shared<MemoryQueue>(capacity);
+    auto backward = std::make_shared<MemoryQueue>(capacity);
+
+    return {MemoryStream{backward, forward}, MemoryStream{forward, backward}};
+}
+
+eof<size_t> MemoryStream::read_into(std::span<unsigned char> data) {
+    if (data.empty()) {
+        return eof((size_t)0, false);
+    }
+
+    while (true) {
+        eof<size_t> result = rx->try_read(data);
+        if (result.value > 0 || result.is_eof) {
+            return result;
+        }
+        rx->readable().wait();
+    }
+}
+
+eof<size_t> MemoryStream::write_from(std::span<const unsigned char> data) {
+    if (data.empty()) {
+        return eof((size_t)0, false);
+    }
+
+    while (true) {
+        eof<size_t> result = tx->try_write(data);
+        if (result.value > 0 || result.is_eof) {
+            return result;
+        }
+        tx->writable().wait();
+    }
+}
+
+AIO<eof<size_t>> MemoryStream::read_async_into(std::span<unsigned char> data) {
+    if (data.empty()) {
+        co_return eof((size_t)0, false);
+    }
+
+    while (true) {
+        eof<size_t> result = rx->try_read(data);
+        if (result.value > 0 || result.is_eof) {
+            co_return result;
+        }
+        co_await event_signaled{rx->readable()};
+    }
+}
+
+AIO<eof<size_t>> MemoryStream::write_async_from(std::span<const unsigned char> data) {
+    if (data.empty()) {
+        co_return eof((size_t)0, false);
+    }
+
+    while (true) {
+        eof<size_t> result = tx->try_write(data);
+        if (result.value > 0 || result.is_eof) {
+            co_return result;
+        }
+        co_await event_signaled{tx->writable()};
+    }
+}
+
+void MemoryStream::shutdown_write() {
+    tx->close_write();
+}
+
+void MemoryStream::shutdown_read() {
+    rx->close_read();
+}
+#pragma endregion MemoryStream
+
+}  // namespace abel
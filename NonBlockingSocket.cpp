@@ -0,0 +1,244 @@
+#include <abel/NonBlockingSocket.hpp>
+
+#include <WS2tcpip.h>
+#include <memory>
+
+namespace abel {
+
+NonBlockingSocket::NonBlockingSocket(OwningSocket socket) :
+    socket_{std::move(socket)}, event{Handle::create_event(true, false)} {
+
+    socket_.validate();
+
+    // Also puts the socket into non-blocking mode
+    int status = WSAEventSelect(
+        socket_.raw(),
+        event.raw(),
+        FD_READ | FD_WRITE | FD_ACCEPT | FD_CONNECT | FD_CLOSE
+    );
+    if (status == SOCKET_ERROR) {
+        fail_ws("Failed to associate socket with event");
+    }
+}
+
+NonBlockingSocket NonBlockingSocket::listen(uint16_t port) {
+    return NonBlockingSocket(Socket::listen(port));
+}
+
+void NonBlockingSocket::poll_events() {
+    WSANETWORKEVENTS events{};
+    int status = WSAEnumNetworkEvents(socket_.raw(), event.raw(), &events);
+    if (status == SOCKET_ERROR) {
+        fail_ws("Failed to enumerate network events");
+    }
+
+    ready |= events.lNetworkEvents;
+    for (int i = 0; i < FD_MAX_EVENTS; ++i) {
+        if (events.lNetworkEvents & (1 << i)) {
+            errors[i] = events.iErrorCode[i];
+        }
+    }
+
+    // A graceful close only means the peer is done sending, and says nothing about our side.
+    // An abortive one does fail writes though, so let writers find out
+    if ((events.lNetworkEvents & FD_CLOSE) && events.iErrorCode[FD_CLOSE_BIT] != 0) {
+        ready |= FD_WRITE;
+    }
+}
+
+void NonBlockingSocket::wait_sync(long mask) {
+    while (!(ready & mask)) {
+        event.wait();
+        poll_events();
+    }
+}
+
+AIO<void> NonBlockingSocket::wait_async(long mask) {
+    while (!(ready & mask)) {
+        co_await event_signaled{event};
+        poll_events();
+    }
+}
+
+AIO<void> NonBlockingSocket::wait_readable() {
+    co_await wait_async(FD_READ | FD_CLOSE);
+}
+
+AIO<void> NonBlockingSocket::wait_writable() {
+    co_await wait_async(FD_WRITE);
+}
+
+std::optional<eof<size_t>> NonBlockingSocket::try_read(std::span<unsigned char> data) {
+    int read = ::recv(socket_.raw(), (char *)data.data(), (int)data.size(), 0);
+    if (read != SOCKET_ERROR) {
+        return eof((size_t)read, read == 0);
+    }
+
+    switch (WSAGetLastError()) {
+    case WSAEWOULDBLOCK:
+        // recv re-enables FD_READ, so it will be reported again once more data arrives
+        ready &= ~FD_READ;
+        return std::nullopt;
+    case WSAECONNRESET:
+    case WSAEDISCON:
+    case WSAESHUTDOWN:
+        return eof((size_t)0, true);
+    default:
+        fail_ws("Failed to read from socket");
+    }
+}
+
+std::optional<eof<size_t>> NonBlockingSocket::try_write(std::span<const unsigned char> data) {
+    int written = ::send(socket_.raw(), (const char *)data.data(), (int)data.size(), 0);
+    if (written != SOCKET_ERROR) {
+        return eof((size_t)written, written == 0);
+    }
+
+    switch (WSAGetLastError()) {
+    case WSAEWOULDBLOCK:
+        // FD_WRITE is only reported again after a send has failed this way
+        ready &= ~FD_WRITE;
+        return std::nullopt;
+    case WSAECONNRESET:
+    case WSAECONNABORTED:
+    case WSAEDISCON:
+    case WSAESHUTDOWN:
+        return eof((size_t)0, true);
+    default:
+        fail_ws("Failed to write to socket");
+    }
+}
+
+std::optional<OwningSocket> NonBlockingSocket::try_accept() {
+    OwningSocket result{::accept(socket_.raw(), nullptr, nullptr)};
+    if (result) {
+        return result;
+    }
+
+    if (WSAGetLastError() != WSAEWOULDBLOCK) {
+        fail_ws("Failed to accept connection");
+    }
+
+    ready &= ~FD_ACCEPT;
+    return std::nullopt;
+}
+
+NonBlockingSocket NonBlockingSocket::accept() {
+    while (true) {
+        std::optional<OwningSocket> result = try_accept();
+        if (result) {
+            // The accepted socket inherits our event association, which the constructor replaces
+            return NonBlockingSocket(std::move(*result));
+        }
+        wait_sync(FD_ACCEPT);
+    }
+}
+
+AIO<NonBlockingSocket> NonBlockingSocket::accept_async() {
+    while (true) {
+        std::optional<OwningSocket> result = try_accept();
+        if (result) {
+            co_return NonBlockingSocket(std::move(*result));
+        }
+        co_await wait_async(FD_ACCEPT);
+    }
+}
+
+AIO<NonBlockingSocket> NonBlockingSocket::connect_async(std::string host, uint16_t port) {
+    addrinfo hints{
+        .ai_family = AF_UNSPEC,
+        .ai_socktype = SOCK_STREAM,
+        .ai_protocol = IPPROTO_TCP,
+    };
+    addrinfo *raw_addrs = nullptr;
+
+    int status = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &raw_addrs);
+    if (status != 0) {
+        fail_ws("Failed to resolve host", status);
+    }
+    std::unique_ptr<addrinfo, decltype(&freeaddrinfo)> addrs{raw_addrs, &freeaddrinfo};
+
+    int last_error = WSAHOST_NOT_FOUND;
+    for (addrinfo *addr = addrs.get(); addr; addr = addr->ai_next) {
+        NonBlockingSocket result(Socket::create(addr->ai_family, addr->ai_socktype, addr->ai_protocol));
+
+        status = ::connect(result.socket_.raw(), addr->ai_addr, (int)addr->ai_addrlen);
+        if (status == SOCKET_ERROR) {
+            last_error = WSAGetLastError();
+            if (last_error != WSAEWOULDBLOCK) {
+                continue;
+            }
+
+            co_await result.wait_async(FD_CONNECT);
+            last_error = result.errors[FD_CONNECT_BIT];
+            if (last_error != 0) {
+                continue;
+            }
+        }
+
+        co_return std::move(result);
+    }
+
+    fail_ws("Failed to connect to socket", last_error);
+}
+
+eof<size_t> NonBlockingSocket::read_into(std::span<unsigned char> data) {
+    while (true) {
+        std::optional<eof<size_t>> result = try_read(data);
+        if (result) {
+            return *result;
+        }
+        wait_sync(FD_READ | FD_CLOSE);
+    }
+}
+
+eof<size_t> NonBlockingSocket::write_from(std::span<const unsigned char> data) {
+    while (true) {
+        std::optional<eof<size_t>> result = try_write(data);
+        if (result) {
+            return *result;
+        }
+        wait_sync(FD_WRITE);
+    }
+}
+
+AIO<eof<size_t>> NonBlockingSocket::read_async_into(std::span<unsigned char> data) {
+    while (true) {
+        std::optional<eof<size_t>> result = try_read(data);
+        if (result) {
+            co_return *result;
+        }
+        co_await wait_async(FD_READ | FD_CLOSE);
+    }
+}
+
+AIO<eof<size_t>> NonBlockingSocket::write_async_from(std::span<const unsigned char> data) {
+    while (true) {
+        std::optional<eof<size_t>> result = try_write(data);
+        if (result) {
+            co_return *result;
+        }
+        co_await wait_async(FD_WRITE);
+    }
+}
+
+AIO<eof<BufferLease>> NonBlockingSocket::read_async_pooled(BufferRing &ring) {
+    while (true) {
+        co_await wait_async(FD_READ | FD_CLOSE);
+
+        BufferLease lease = co_await ring.borrow_async();
+
+        // Someone else may have drained the socket while we were waiting for the buffer
+        std::optional<eof<size_t>> result = try_read(lease.capacity());
+        if (result) {
+            lease.resize(result->value);
+            co_return eof<BufferLease>{std::move(lease), result->is_eof};
+        }
+    }
+}
+
+void NonBlockingSocket::shutdown(int how) {
+    socket_.shutdown(how);
+}
+
+}  // namespace abel
@@ -4,6 +4,7 @@
 #include <cstdio>
 
 #include <abel/Error.hpp>
+#include <abel/IOPool.hpp>
 
 namespace abel {
 
@@ -30,10 +31,22 @@ Pipe Pipe::create(bool inheritHandles, DWORD bufSize) {
     result.read.validate();
     result.write.validate();
 
+    // Anonymous pipes are always synchronous
+    BlockingIOPool::register_synchronous(result.read);
+    BlockingIOPool::register_synchronous(result.write);
+
     return result;
 }
 
 Pipe Pipe::create_async(bool inheritHandles, DWORD bufSize) {
+    return create_async(pipe_options{
+        .capacity = bufSize,
+        .inherit_read = inheritHandles,
+        .inherit_write = inheritHandles,
+    });
+}
+
+Pipe Pipe::create_async(const pipe_options &options) {
     static std::atomic<unsigned> pipe_id{0};
 
     char name[MAX_PATH] = {};
@@ -41,41 +54,66 @@ Pipe Pipe::create_async(bool inheritHandles, DWORD bufSize) {
     sprintf_s(
         name,
         sizeof(name),
-        "\\\\.\\Pipe\\RemoteCMD.%08x.%08x",
+        "\\\\.\\Pipe\\abel.%08x.%08x",
         GetCurrentProcessId(),
         pipe_id.fetch_add(1)
     );
 
     Pipe result{};
 
-    SECURITY_ATTRIBUTES sa{
+    SECURITY_ATTRIBUTES read_sa{
         .nLength = sizeof(SECURITY_ATTRIBUTES),
         .lpSecurityDescriptor = nullptr,
-        .bInheritHandle = inheritHandles,
+        .bInheritHandle = options.inherit_read,
     };
 
+    SECURITY_ATTRIBUTES write_sa{
+        .nLength = sizeof(SECURITY_ATTRIBUTES),
+        .lpSecurityDescriptor = nullptr,
+        .bInheritHandle = options.inherit_write,
+    };
+
+    // Data only flows inbound, so only the input buffer size matters.
+    // FILE_FLAG_FIRST_PIPE_INSTANCE makes sure nobody else has grabbed the name before us
     result.read = OwningHandle(CreateNamedPipeA(
         name,
-        PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED,
-        PIPE_TYPE_BYTE | PIPE_WAIT,
+        PIPE_ACCESS_INBOUND | FILE_FLAG_FIRST_PIPE_INSTANCE | (options.overlapped_read ? FILE_FLAG_OVERLAPPED : 0),
+        PIPE_TYPE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
         1,
-        bufSize,
-        bufSize,
+        0,
+        options.capacity,
         120 * 1000,
-        &sa
+        &read_sa
     )).validate();
 
     result.write = OwningHandle(CreateFileA(
         name,
         GENERIC_WRITE,
         0,
-        &sa,
+        &write_sa,
         OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+        FILE_ATTRIBUTE_NORMAL | (options.overlapped_write ? FILE_FLAG_OVERLAPPED : 0),
         NULL
     )).validate();
 
+    if (!options.overlapped_read) {
+        BlockingIOPool::register_synchronous(result.read);
+    }
+    if (!options.overlapped_write) {
+        BlockingIOPool::register_synchronous(result.write);
+    }
+
     return result;
 }
 
+DWORD Pipe::capacity() const {
+    DWORD in_size = 0;
+    bool success = GetNamedPipeInfo(read.raw(), nullptr, nullptr, &in_size, nullptr);
+    if (!success) {
+        fail("Failed to query pipe info");
+    }
+
+    return in_size;
+}
+
 }  // namespace abel
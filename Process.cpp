@@ -2,6 +2,7 @@
 
 #include <Windows.h>
 #include <TlHelp32.h>
+#include <Psapi.h>
 #include <utility>
 
 #include <abel/Error.hpp>
@@ -100,4 +101,17 @@ OwningHandle Process::find(std::string_view name) {
     fail("Process not found");
 }
 
+size_t Process::working_set(Handle process) {
+    PROCESS_MEMORY_COUNTERS counters{
+        .cb = sizeof(counters)
+    };
+
+    bool success = GetProcessMemoryInfo(process.raw(), &counters, sizeof(counters));
+    if (!success) {
+        fail("Failed to query process memory info");
+    }
+
+    return counters.WorkingSetSize;
+}
+
 }  // namespace abel
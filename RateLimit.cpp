@@ -0,0 +1,58 @@
+#include <abel/RateLimit.hpp>
+
+#include <abel/Error.hpp>
+
+#include <cmath>
+
+namespace abel {
+
+TokenBucket::TokenBucket(double rate, double burst) :
+    rate{0}, burst{0}, tokens{0}, last_refill{aio_clock::now()} {
+
+    set_rate(rate, burst);
+    tokens = this->burst;
+}
+
+void TokenBucket::refill(aio_clock::time_point now) noexcept {
+    if (now <= last_refill) {
+        return;
+    }
+
+    double elapsed = std::chrono::duration<double>(now - last_refill).count();
+    tokens = std::min<double>(burst, tokens + elapsed * rate);
+    last_refill = now;
+}
+
+size_t TokenBucket::available(aio_clock::time_point now) noexcept {
+    refill(now);
+    return tokens > 0 ? (size_t)tokens : 0;
+}
+
+void TokenBucket::consume(size_t amount) noexcept {
+    // May go negative if more was consumed than granted; the debt is repaid by the refill
+    tokens -= (double)amount;
+}
+
+aio_clock::time_point TokenBucket::ready_at(size_t amount, aio_clock::time_point now) noexcept {
+    refill(now);
+
+    double missing = std::min<double>((double)amount, burst) - tokens;
+    if (missing <= 0) {
+        return now;
+    }
+
+    return now + std::chrono::ceil<aio_clock::duration>(std::chrono::duration<double>(missing / rate));
+}
+
+void TokenBucket::set_rate(double rate_, double burst_) {
+    if (!(rate_ > 0) || !(burst_ >= 1) || !std::isfinite(rate_) || !std::isfinite(burst_)) {
+        fail("Invalid token bucket parameters");
+    }
+
+    refill();
+    rate = rate_;
+    burst = burst_;
+    tokens = std::min<double>(tokens, burst);
+}
+
+}  // namespace abel
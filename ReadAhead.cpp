@@ -0,0 +1,196 @@
+#include <abel/ReadAhead.hpp>
+
+#include <cstring>
+#include <algorithm>
+
+namespace abel {
+
+ReadAhead::ReadAhead(Handle file, readahead_options options_, uint64_t start) :
+    file{file}, options{options_} {
+
+    options.depth = std::max<size_t>(options.depth, 1);
+    options.min_window = std::max<size_t>(options.min_window, 4096);
+    options.max_window = std::max<size_t>(options.max_window, options.min_window);
+
+    stats_.window_size = options.min_window;
+    known_size = file.file_size();
+    position = start;
+    next_offset = start;
+    // Reading from wherever we were told to start is assumed to be sequential
+    sequential_run = options.sequential_threshold;
+}
+
+void ReadAhead::refill() {
+    if (!prefetching()) {
+        return;
+    }
+
+    while (windows.size() < options.depth && next_offset < known_size) {
+        std::unique_ptr<window> slot{};
+        if (!spare.empty()) {
+            slot = std::move(spare.back());
+            spare.pop_back();
+        } else {
+            slot = std::make_unique<window>();
+        }
+
+        size_t length = (size_t)std::min<uint64_t>(stats_.window_size, known_size - next_offset);
+        if (slot->capacity < length) {
+            slot->buf = std::make_unique_for_overwrite<unsigned char[]>(length);
+            slot->capacity = length;
+        }
+
+        slot->offset = next_offset;
+        slot->length = length;
+        slot->filled = 0;
+        slot->consumed = 0;
+        // If the file has shrunk, this may hit the end right away; the window then simply stays empty
+        slot->pending = file.begin_read_at(slot->op, next_offset, {slot->buf.get(), length});
+
+        next_offset += length;
+        windows.push_back(std::move(slot));
+    }
+}
+
+void ReadAhead::drop_windows() noexcept {
+    while (!windows.empty()) {
+        windows.back()->op.cancel();
+        windows.back()->pending = false;
+        spare.push_back(std::move(windows.back()));
+        windows.pop_back();
+    }
+}
+
+void ReadAhead::complete(window &front, bool was_ready) {
+    eof<size_t> result = front.op.result();
+    front.filled = result.value;
+    front.pending = false;
+    stats_.prefetched_bytes += result.value;
+
+    if (!was_ready) {
+        stats_.window_size = std::min<size_t>(stats_.window_size * 2, options.max_window);
+        hit_streak = 0;
+    } else if (++hit_streak >= options.depth) {
+        // The reader is slower than the disk, so there is no point in holding as much memory
+        stats_.window_size = std::max<size_t>(stats_.window_size / 2, options.min_window);
+        hit_streak = 0;
+    }
+}
+
+bool ReadAhead::ensure_front() {
+    if (!windows.empty()) {
+        return true;
+    }
+
+    if (next_offset >= known_size) {
+        // The file may have grown since
+        known_size = file.file_size();
+    }
+
+    refill();
+    return !windows.empty();
+}
+
+eof<size_t> ReadAhead::consume(std::span<unsigned char> data) {
+    window &front = *windows.front();
+
+    size_t read = std::min<size_t>(data.size(), front.filled - front.consumed);
+    std::memcpy(data.data(), front.buf.get() + front.consumed, read);
+    front.consumed += read;
+    position += read;
+
+    if (front.consumed == front.filled) {
+        bool truncated = front.filled < front.length;
+
+        spare.push_back(std::move(windows.front()));
+        windows.pop_front();
+
+        if (truncated) {
+            // The file ended earlier than expected, so everything prefetched past this point is bogus
+            drop_windows();
+            next_offset = position;
+            known_size = position;
+        }
+    }
+
+    if (read == 0) {
+        return eof((size_t)0, true);
+    }
+
+    refill();
+    return eof(read, false);
+}
+
+void ReadAhead::seek(uint64_t offset) {
+    if (offset == position) {
+        return;
+    }
+
+    drop_windows();
+    position = offset;
+    next_offset = offset;
+    sequential_run = 0;
+}
+
+eof<size_t> ReadAhead::read_into(std::span<unsigned char> data) {
+    if (data.empty()) {
+        return eof((size_t)0, false);
+    }
+
+    if (!prefetching()) {
+        ++stats_.direct_reads;
+        eof<size_t> result = file.read_at(position, data);
+        position += result.value;
+        next_offset = position;
+        ++sequential_run;
+        return result;
+    }
+
+    if (!ensure_front()) {
+        return eof((size_t)0, true);
+    }
+
+    window &front = *windows.front();
+    bool ready = !front.pending || front.op.is_done();
+    ++(ready ? stats_.hits : stats_.misses);
+
+    if (front.pending) {
+        complete(front, ready);
+    }
+
+    return consume(data);
+}
+
+AIO<eof<size_t>> ReadAhead::read_async_into(std::span<unsigned char> data) {
+    if (data.empty()) {
+        co_return eof((size_t)0, false);
+    }
+
+    if (!prefetching()) {
+        ++stats_.direct_reads;
+        eof<size_t> result = co_await file.read_async_at(position, data);
+        position += result.value;
+        next_offset = position;
+        ++sequential_run;
+        co_return result;
+    }
+
+    if (!ensure_front()) {
+        co_return eof((size_t)0, true);
+    }
+
+    window &front = *windows.front();
+    bool ready = !front.pending || front.op.is_done();
+    ++(ready ? stats_.hits : stats_.misses);
+
+    if (front.pending) {
+        if (!ready) {
+            co_await event_signaled{front.op.event_done()};
+        }
+        complete(front, ready);
+    }
+
+    co_return consume(data);
+}
+
+}  // namespace abel
@@ -0,0 +1,73 @@
+#include <abel/ReceiveEngine.hpp>
+
+#include <algorithm>
+
+namespace abel {
+
+ReceiveEngine::ReceiveEngine(uint16_t port, handler_t handler, receive_engine_options options) :
+    listener{Socket::listen(port)},
+    ring{options.buffer_size, options.buffers},
+    handler{std::move(handler)} {
+
+    size_t count = std::max<size_t>(options.accepts, 1);
+    for (size_t i = 0; i < count; ++i) {
+        accepts.push_back(std::make_unique<PendingAccept>(listener.borrow()));
+        drainer.add_acceptor(*accepts.back());
+    }
+}
+
+void ReceiveEngine::run(Handle stop, aio_clock::duration drain_timeout) {
+    for (auto &accept : accepts) {
+        tasks.add(accept_loop(*accept));
+    }
+
+    tasks.run(stop);
+
+    drainer.drain(tasks, aio_clock::now() + drain_timeout);
+}
+
+AIO<void> ReceiveEngine::accept_loop(PendingAccept &accept) {
+    while (true) {
+        OwningSocket connection = co_await accept.accept_async();
+        if (!connection) {
+            // Draining
+            co_return;
+        }
+        ++stats_.accepted;
+
+        tasks.add(serve(std::move(connection)));
+    }
+}
+
+AIO<void> ReceiveEngine::serve(OwningSocket connection) {
+    DrainTicket ticket = drainer.track(connection.borrow());
+
+    try {
+        while (true) {
+            if (ticket.draining()) {
+                // Between chunks, so nothing of ours is in flight; keep reading until the peer closes too
+                ticket.finish();
+            }
+
+            ticket.set_idle(true);
+            eof<BufferLease> chunk = co_await connection.read_async_pooled(ring);
+            ticket.set_idle(false);
+            if (chunk.is_eof) {
+                break;
+            }
+
+            ++stats_.deliveries;
+            stats_.received_bytes += chunk.value.size();
+
+            if (!co_await handler(connection.borrow(), std::move(chunk.value))) {
+                break;
+            }
+        }
+    } catch (...) {
+        // A broken connection just ends its own task
+    }
+
+    ++stats_.closed;
+}
+
+}  // namespace abel
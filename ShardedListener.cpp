@@ -0,0 +1,206 @@
+#include <abel/ShardedListener.hpp>
+
+#include <MSWSock.h>
+#include <algorithm>
+
+namespace abel {
+
+#pragma region PendingAccept
+PendingAccept::PendingAccept(Socket listener, int family) :
+    listener{listener}, family{family} {
+
+    post();
+}
+
+void PendingAccept::post() {
+    candidate = Socket::create(family);
+    overlapped = op.prepare(listener.io_handle());
+    op.event_done().reset();
+
+    DWORD received = 0;
+    bool success = AcceptEx(
+        listener.raw(),
+        candidate.raw(),
+        addresses,
+        0,
+        address_size,
+        address_size,
+        &received,
+        overlapped
+    );
+
+    if (!success && WSAGetLastError() != ERROR_IO_PENDING) {
+        fail_ws("Failed to post accept");
+    }
+}
+
+AIO<OwningSocket> PendingAccept::accept_async() {
+    while (true) {
+        if (!candidate) {
+            // Stopped, and nothing is posted anymore
+            co_return OwningSocket{};
+        }
+
+        co_await event_signaled{op.event_done()};
+
+        DWORD transmitted = 0;
+        DWORD flags = 0;
+        bool success = WSAGetOverlappedResult(
+            listener.raw(),
+            (WSAOVERLAPPED *)overlapped,
+            &transmitted,
+            false,
+            &flags
+        );
+        int error = success ? 0 : WSAGetLastError();
+
+        OwningSocket result = std::move(candidate);
+        if (!stopped) {
+            post();
+        }
+
+        if (!success) {
+            switch (error) {
+            case WSAECONNRESET:
+            case ERROR_NETNAME_DELETED:
+            case WSA_OPERATION_ABORTED:
+                continue;
+            default:
+                fail_ws("Failed to accept connection", error);
+            }
+        }
+
+        // Without this, the accepted socket doesn't support getpeername, shutdown and the like
+        SOCKET listener_raw = listener.raw();
+        int status = setsockopt(
+            result.raw(),
+            SOL_SOCKET,
+            SO_UPDATE_ACCEPT_CONTEXT,
+            (const char *)&listener_raw,
+            sizeof(listener_raw)
+        );
+        if (status == SOCKET_ERROR) {
+            fail_ws("Failed to update accepted socket context");
+        }
+
+        co_return std::move(result);
+    }
+}
+
+void PendingAccept::stop() noexcept {
+    stopped = true;
+    op.cancel();
+}
+#pragma endregion PendingAccept
+
+#pragma region ShardedListener
+ShardedListener::ShardedListener(uint16_t port, sharded_listener_options options) :
+    listener{Socket::listen(port)} {
+
+    size_t count = options.shards;
+    if (count == 0) {
+        SYSTEM_INFO info{};
+        GetSystemInfo(&info);
+        count = info.dwNumberOfProcessors;
+    }
+    count = std::max<size_t>(count, 1);
+
+    size_t accepts = std::max<size_t>(options.accepts_per_shard, 1);
+
+    for (size_t i = 0; i < count; ++i) {
+        auto result = std::make_unique<shard>();
+        result->owner = this;
+        result->index = i;
+        result->accept_count = accepts;
+        shards.push_back(std::move(result));
+    }
+}
+
+ShardedListener::~ShardedListener() noexcept {
+    stop();
+}
+
+void ShardedListener::start(handler_t handler_) {
+    stop();
+
+    handler = std::move(handler_);
+
+    DWORD processors = std::max<DWORD>(GetActiveProcessorCount(ALL_PROCESSOR_GROUPS), 1);
+    for (auto &worker : shards) {
+        worker->thread = Thread::create<shard, &shard::run>(worker.get());
+        // A hint rather than a pin, so that the scheduler may still move us if a core is busy
+        SetThreadIdealProcessor(worker->thread->handle.raw(), (DWORD)(worker->index % processors));
+    }
+}
+
+void ShardedListener::stop(aio_clock::duration drain_timeout) noexcept {
+    drain_deadline = aio_clock::now() + drain_timeout;
+    draining_.store(true);
+    stop_event.signal();
+
+    drain_stats total{};
+    bool running = false;
+    for (auto &worker : shards) {
+        if (worker->thread) {
+            running = true;
+            worker->thread->handle.wait();
+            worker->thread.reset();
+
+            total.drained += worker->drained.drained;
+            total.aborted += worker->drained.aborted;
+            total.drain_time = std::max<aio_clock::duration>(total.drain_time, worker->drained.drain_time);
+        }
+    }
+    if (running) {
+        drain_results_ = total;
+    }
+
+    stop_event.reset();
+    draining_.store(false);
+}
+
+void ShardedListener::shard::run() {
+    // Created afresh for every start, since draining stops them for good
+    std::vector<std::unique_ptr<PendingAccept>> accepts{};
+    ConnectionDrainer drainer{};
+    // Last, since the tasks refer to the above
+    TaskSet tasks{};
+    for (size_t i = 0; i < accept_count; ++i) {
+        accepts.push_back(std::make_unique<PendingAccept>(owner->listener.borrow()));
+        drainer.add_acceptor(*accepts.back());
+        tasks.add(accept_loop(*accepts.back(), drainer, tasks));
+    }
+
+    tasks.run(owner->stop_event);
+
+    drainer.drain(tasks, owner->drain_deadline);
+
+    drained = drainer.stats();
+}
+
+AIO<void> ShardedListener::shard::accept_loop(PendingAccept &accept, ConnectionDrainer &drainer, TaskSet &tasks) {
+    while (true) {
+        OwningSocket connection = co_await accept.accept_async();
+        if (!connection) {
+            // Draining
+            co_return;
+        }
+        ++accepted;
+
+        tasks.add(serve(std::move(connection), drainer));
+    }
+}
+
+AIO<void> ShardedListener::shard::serve(OwningSocket connection, ConnectionDrainer &drainer) {
+    // Both go to the handler, which owns the connection from now on
+    DrainTicket ticket = drainer.track(connection.borrow());
+
+    try {
+        co_await owner->handler(std::move(connection), std::move(ticket));
+    } catch (...) {
+        // Its parameters are gone along with its frame, so there's nothing left to clean up here
+    }
+}
+#pragma endregion ShardedListener
+
+}  // namespace abel
@@ -0,0 +1,329 @@
+#include <abel/SharedRingChannel.hpp>
+
+#include <bit>
+#include <new>
+#include <chrono>
+#include <cstring>
+#include <utility>
+#include <algorithm>
+
+namespace abel {
+
+// How often asynchronous waits check on a watched peer
+static constexpr auto peer_poll_interval = std::chrono::milliseconds(100);
+
+SharedRingChannel::SharedRingChannel(SharedRingChannel &&other) noexcept :
+    SharedRingChannel() {
+    *this = std::move(other);
+}
+
+SharedRingChannel &SharedRingChannel::operator=(SharedRingChannel &&other) noexcept {
+    std::swap(mapping_, other.mapping_);
+    std::swap(events, other.events);
+    std::swap(header, other.header);
+    std::swap(in, other.in);
+    std::swap(out, other.out);
+    std::swap(in_data, other.in_data);
+    std::swap(out_data, other.out_data);
+    std::swap(peer_process, other.peer_process);
+    std::swap(stats_, other.stats_);
+    return *this;
+}
+
+SharedRingChannel::~SharedRingChannel() noexcept {
+    close();
+}
+
+SharedRingChannel SharedRingChannel::create(size_t capacity) {
+    capacity = std::bit_ceil<size_t>(std::max<size_t>(capacity, 4096));
+    uint64_t total = sizeof(shared_header) + 2 * (uint64_t)capacity;
+
+    SECURITY_ATTRIBUTES sa{
+        .nLength = sizeof(SECURITY_ATTRIBUTES),
+        .lpSecurityDescriptor = nullptr,
+        .bInheritHandle = true,
+    };
+
+    SharedRingChannel result{};
+
+    // Backed by the paging file rather than an actual file
+    result.mapping_ = OwningHandle(CreateFileMappingA(
+        INVALID_HANDLE_VALUE,
+        &sa,
+        PAGE_READWRITE,
+        (DWORD)(total >> 32),
+        (DWORD)(total & 0xFFFFFFFF),
+        nullptr
+    )).validate();
+
+    for (auto &event : result.events) {
+        event = Handle::create_event(true, false, true);
+    }
+
+    result.map();
+
+    // Fresh pages are zeroed, but the atomics still have to be constructed properly
+    shared_header *header = new (result.header) shared_header{};
+    header->magic = header_magic;
+    header->capacity = capacity;
+    for (size_t i = 0; i < 2; ++i) {
+        header->rings[i].data_event = (uint64_t)result.events[2 * i].raw();
+        header->rings[i].space_event = (uint64_t)result.events[2 * i + 1].raw();
+    }
+
+    result.select_rings(true);
+
+    return result;
+}
+
+SharedRingChannel SharedRingChannel::attach(OwningHandle mapping) {
+    SharedRingChannel result{};
+
+    result.mapping_ = std::move(mapping);
+    result.mapping_.validate();
+
+    result.map();
+
+    if (result.header->magic != header_magic) {
+        fail("Not a shared ring channel mapping");
+    }
+
+    // Inherited along with the mapping, so they are ours to close as well
+    for (size_t i = 0; i < 2; ++i) {
+        result.events[2 * i] = OwningHandle((HANDLE)result.header->rings[i].data_event);
+        result.events[2 * i + 1] = OwningHandle((HANDLE)result.header->rings[i].space_event);
+    }
+
+    result.select_rings(false);
+
+    return result;
+}
+
+void SharedRingChannel::map() {
+    void *view = MapViewOfFile(mapping_.raw(), FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (!view) {
+        fail("Failed to map shared ring channel");
+    }
+
+    header = (shared_header *)view;
+}
+
+void SharedRingChannel::select_rings(bool creator_side) noexcept {
+    unsigned char *data = (unsigned char *)header + sizeof(shared_header);
+    size_t capacity = (size_t)header->capacity;
+
+    size_t out_idx = creator_side ? 0 : 1;
+    size_t in_idx = 1 - out_idx;
+
+    out = &header->rings[out_idx];
+    out_data = data + out_idx * capacity;
+    in = &header->rings[in_idx];
+    in_data = data + in_idx * capacity;
+}
+
+void SharedRingChannel::close() noexcept {
+    if (!header) {
+        return;
+    }
+
+    // The peer may be asleep waiting for either, so no point in checking the flags
+    out->producer_closed.store(1);
+    in->consumer_closed.store(1);
+    Handle((HANDLE)out->data_event).signal();
+    Handle((HANDLE)in->space_event).signal();
+
+    UnmapViewOfFile(header);
+    header = nullptr;
+    in = nullptr;
+    out = nullptr;
+    in_data = nullptr;
+    out_data = nullptr;
+}
+
+bool SharedRingChannel::peer_gone() const {
+    return peer_process && peer_process.is_signaled();
+}
+
+// Note: these must stay sequentially consistent to pair up with the sleeping flags
+bool SharedRingChannel::can_read() const {
+    return in->head.load() != in->tail.load() || in->producer_closed.load() || peer_gone();
+}
+
+bool SharedRingChannel::can_write() const {
+    return out->head.load() - out->tail.load() < header->capacity || out->consumer_closed.load() || peer_gone();
+}
+
+void SharedRingChannel::wake(std::atomic<uint32_t> &sleeping, uint64_t event) {
+    if (sleeping.exchange(0)) {
+        Handle((HANDLE)event).signal();
+        ++stats_.wakeups;
+    }
+}
+
+template <typename F>
+bool SharedRingChannel::prepare_sleep(std::atomic<uint32_t> &sleeping, Handle event, F ready) {
+    // Any stale signal is cleared before the flag goes up, so a signal seen later is always a fresh one
+    event.reset();
+    sleeping.store(1);
+
+    if (ready()) {
+        sleeping.store(0);
+        return false;
+    }
+
+    ++stats_.sleeps;
+    return true;
+}
+
+void SharedRingChannel::wait_sync(std::atomic<uint32_t> &sleeping, uint64_t event, bool for_data) {
+    Handle target((HANDLE)event);
+    bool should_sleep = prepare_sleep(sleeping, target, [&] {
+        return for_data ? can_read() : can_write();
+    });
+    if (!should_sleep) {
+        return;
+    }
+
+    if (peer_process) {
+        Handle::wait_multiple(target, peer_process);
+    } else {
+        target.wait();
+    }
+    sleeping.store(0);
+}
+
+AIO<void> SharedRingChannel::wait_async(std::atomic<uint32_t> &sleeping, uint64_t event, bool for_data) {
+    Handle target((HANDLE)event);
+    bool should_sleep = prepare_sleep(sleeping, target, [&] {
+        return for_data ? can_read() : can_write();
+    });
+    if (!should_sleep) {
+        co_return;
+    }
+
+    if (peer_process) {
+        while (!co_await event_signaled_until{target, aio_clock::now() + peer_poll_interval}) {
+            if (peer_gone()) {
+                break;
+            }
+        }
+    } else {
+        co_await event_signaled{target};
+    }
+    sleeping.store(0);
+}
+
+size_t SharedRingChannel::copy_in(std::span<unsigned char> data) {
+    size_t capacity = (size_t)header->capacity;
+    uint64_t tail = in->tail.load(std::memory_order_relaxed);
+    uint64_t head = in->head.load(std::memory_order_acquire);
+
+    size_t count = (size_t)std::min<uint64_t>(data.size(), head - tail);
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t pos = (size_t)(tail & (capacity - 1));
+    size_t first = std::min<size_t>(count, capacity - pos);
+    std::memcpy(data.data(), in_data + pos, first);
+    std::memcpy(data.data() + first, in_data, count - first);
+
+    in->tail.store(tail + count);
+    wake(in->writer_sleeping, in->space_event);
+
+    return count;
+}
+
+size_t SharedRingChannel::copy_out(std::span<const unsigned char> data) {
+    size_t capacity = (size_t)header->capacity;
+    uint64_t head = out->head.load(std::memory_order_relaxed);
+    uint64_t tail = out->tail.load(std::memory_order_acquire);
+
+    size_t count = (size_t)std::min<uint64_t>(data.size(), capacity - (head - tail));
+    if (count == 0) {
+        return 0;
+    }
+
+    size_t pos = (size_t)(head & (capacity - 1));
+    size_t first = std::min<size_t>(count, capacity - pos);
+    std::memcpy(out_data + pos, data.data(), first);
+    std::memcpy(out_data, data.data() + first, count - first);
+
+    out->head.store(head + count);
+    wake(out->reader_sleeping, out->data_event);
+
+    return count;
+}
+
+eof<size_t> SharedRingChannel::read_into(std::span<unsigned char> data) {
+    while (true) {
+        size_t read = copy_in(data);
+        if (read > 0 || data.empty()) {
+            return eof(read, false);
+        }
+
+        if (in->producer_closed.load() || peer_gone()) {
+            // Whatever was written right before closing
+            read = copy_in(data);
+            return eof(read, read == 0);
+        }
+
+        wait_sync(in->reader_sleeping, in->data_event, true);
+    }
+}
+
+eof<size_t> SharedRingChannel::write_from(std::span<const unsigned char> data) {
+    while (true) {
+        if (out->consumer_closed.load()) {
+            return eof((size_t)0, true);
+        }
+
+        size_t written = copy_out(data);
+        if (written > 0 || data.empty()) {
+            return eof(written, false);
+        }
+
+        if (peer_gone()) {
+            return eof((size_t)0, true);
+        }
+
+        wait_sync(out->writer_sleeping, out->space_event, false);
+    }
+}
+
+AIO<eof<size_t>> SharedRingChannel::read_async_into(std::span<unsigned char> data) {
+    while (true) {
+        size_t read = copy_in(data);
+        if (read > 0 || data.empty()) {
+            co_return eof(read, false);
+        }
+
+        if (in->producer_closed.load() || peer_gone()) {
+            read = copy_in(data);
+            co_return eof(read, read == 0);
+        }
+
+        co_await wait_async(in->reader_sleeping, in->data_event, true);
+    }
+}
+
+AIO<eof<size_t>> SharedRingChannel::write_async_from(std::span<const unsigned char> data) {
+    while (true) {
+        if (out->consumer_closed.load()) {
+            co_return eof((size_t)0, true);
+        }
+
+        size_t written = copy_out(data);
+        if (written > 0 || data.empty()) {
+            co_return eof(written, false);
+        }
+
+        if (peer_gone()) {
+            co_return eof((size_t)0, true);
+        }
+
+        co_await wait_async(out->writer_sleeping, out->space_event, false);
+    }
+}
+
+}  // namespace abel
@@ -1,18 +1,24 @@
 #include <abel/Socket.hpp>
 
+#include <WS2tcpip.h>
+#include <MSWSock.h>
+#include <afunix.h>
 #include <memory>
+#include <vector>
+#include <algorithm>
 
 #include <abel/Concurrency.hpp>
+#include <abel/BufferRing.hpp>
 
 namespace abel {
 
-OwningSocket Socket::create() {
+OwningSocket Socket::create(int family, int type, int protocol) {
     // TODO: Change if I ever want to inherit socket handles. For now it would only serve to leak the bound port
     return OwningSocket(
         WSASocketA(
-            AF_INET,
-            SOCK_STREAM,
-            0,
+            family,
+            type,
+            protocol,
             nullptr,
             0,
             WSA_FLAG_OVERLAPPED | WSA_FLAG_NO_HANDLE_INHERIT
@@ -32,6 +38,208 @@ OwningSocket Socket::connect(std::string host, uint16_t port) {
     return result;
 }
 
+// A single ConnectEx attempt of Socket::connect_async. Cancels itself if it is still in progress when destroyed.
+struct _impl_ConnectAttempt {
+    OwningSocket socket{};
+    OVERLAPPED overlapped{};
+    bool pending = false;
+
+    _impl_ConnectAttempt() = default;
+
+    _impl_ConnectAttempt(const _impl_ConnectAttempt &other) = delete;
+    _impl_ConnectAttempt &operator=(const _impl_ConnectAttempt &other) = delete;
+
+    ~_impl_ConnectAttempt() noexcept {
+        if (!pending) {
+            return;
+        }
+
+        CancelIoEx(socket.io_handle().raw(), &overlapped);
+
+        // Waiting on the event won't do: it is shared with the other attempts, and may well be signaled already.
+        // Cancellation completes promptly, so polling is fine
+        while (!HasOverlappedIoCompleted(&overlapped)) {
+            Sleep(1);
+        }
+    }
+
+    // Returns the error code the attempt failed with right away, if any
+    int start(const addrinfo &addr, Handle done) {
+        // Not Socket::create, since a family that's unavailable here (e.g. IPv6 being disabled)
+        // should only rule out this address rather than fail the whole race
+        socket = OwningSocket(WSASocketA(
+            addr.ai_family,
+            addr.ai_socktype,
+            addr.ai_protocol,
+            nullptr,
+            0,
+            WSA_FLAG_OVERLAPPED | WSA_FLAG_NO_HANDLE_INHERIT
+        ));
+        if (!socket) {
+            return WSAGetLastError();
+        }
+
+        // ConnectEx insists on a bound socket
+        sockaddr_storage local{.ss_family = (ADDRESS_FAMILY)addr.ai_family};
+        int status = ::bind(socket.raw(), (sockaddr *)&local, (int)addr.ai_addrlen);
+        if (status == SOCKET_ERROR) {
+            return WSAGetLastError();
+        }
+
+        LPFN_CONNECTEX connect_ex = nullptr;
+        GUID guid = WSAID_CONNECTEX;
+        DWORD returned = 0;
+        status = WSAIoctl(
+            socket.raw(),
+            SIO_GET_EXTENSION_FUNCTION_POINTER,
+            &guid,
+            sizeof(guid),
+            &connect_ex,
+            sizeof(connect_ex),
+            &returned,
+            nullptr,
+            nullptr
+        );
+        if (status == SOCKET_ERROR) {
+            return WSAGetLastError();
+        }
+
+        overlapped = OVERLAPPED{.hEvent = done.raw()};
+        bool success = connect_ex(socket.raw(), addr.ai_addr, (int)addr.ai_addrlen, nullptr, 0, nullptr, &overlapped);
+        if (!success && WSAGetLastError() != ERROR_IO_PENDING) {
+            return WSAGetLastError();
+        }
+
+        // Even if it has completed already, the event gets signaled
+        pending = true;
+        return 0;
+    }
+
+    // Only valid once the attempt has completed. Returns 0 on success, or the error code otherwise
+    int finish() {
+        pending = false;
+
+        DWORD transmitted = 0;
+        DWORD flags = 0;
+        bool success = WSAGetOverlappedResult(socket.raw(), (WSAOVERLAPPED *)&overlapped, &transmitted, false, &flags);
+        if (!success) {
+            return WSAGetLastError();
+        }
+
+        // Without this, the socket doesn't support getpeername, shutdown and the like
+        int status = setsockopt(socket.raw(), SOL_SOCKET, SO_UPDATE_CONNECT_CONTEXT, nullptr, 0);
+        if (status == SOCKET_ERROR) {
+            return WSAGetLastError();
+        }
+
+        return 0;
+    }
+};
+
+AIO<OwningSocket> Socket::connect_async(
+    std::string host,
+    uint16_t port,
+    aio_clock::time_point deadline,
+    aio_clock::duration stagger
+) {
+    addrinfo hints{
+        .ai_family = AF_UNSPEC,
+        .ai_socktype = SOCK_STREAM,
+        .ai_protocol = IPPROTO_TCP,
+    };
+    addrinfo *raw_addrs = nullptr;
+
+    int status = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &raw_addrs);
+    if (status != 0) {
+        fail_ws("Failed to resolve host", status);
+    }
+    std::unique_ptr<addrinfo, decltype(&freeaddrinfo)> addrs_holder{raw_addrs, &freeaddrinfo};
+
+    // Interleave the families, so that a broken IPv6 route doesn't hold up IPv4 and vice versa
+    std::vector<const addrinfo *> primary{};
+    std::vector<const addrinfo *> secondary{};
+    for (const addrinfo *addr = raw_addrs; addr; addr = addr->ai_next) {
+        (addr->ai_family == raw_addrs->ai_family ? primary : secondary).push_back(addr);
+    }
+
+    std::vector<const addrinfo *> addrs{};
+    for (size_t i = 0; i < std::max<size_t>(primary.size(), secondary.size()); ++i) {
+        if (i < primary.size()) {
+            addrs.push_back(primary[i]);
+        }
+        if (i < secondary.size()) {
+            addrs.push_back(secondary[i]);
+        }
+    }
+
+    // Shared by all attempts, so that we can wait on all of them at once
+    OwningHandle done = Handle::create_event(true, false);
+    std::vector<std::unique_ptr<_impl_ConnectAttempt>> attempts{};
+    size_t next = 0;
+    size_t active = 0;
+    aio_clock::time_point next_start = aio_clock::now();
+    int last_error = WSAETIMEDOUT;
+
+    while (true) {
+        bool timed_out = aio_clock::now() >= deadline;
+        if (!timed_out && next < addrs.size() && (active == 0 || aio_clock::now() >= next_start)) {
+            auto attempt = std::make_unique<_impl_ConnectAttempt>();
+            int error = attempt->start(*addrs[next++], done);
+            if (error != 0) {
+                // No point in waiting before trying the next one
+                last_error = error;
+                continue;
+            }
+
+            next_start = aio_clock::now() + stagger;
+            ++active;
+            attempts.push_back(std::move(attempt));
+        }
+
+        if (active == 0) {
+            if (timed_out) {
+                fail_ws("Timed out connecting to socket", WSAETIMEDOUT);
+            }
+            fail_ws("Failed to connect to socket", last_error);
+        }
+
+        // Starting a ConnectEx resets the shared event, which may swallow the signal of an attempt
+        // that completed just before, so every pass checks all of them rather than trusting the event.
+        // Resetting before checking ensures that completions past this point signal it again
+        done.reset();
+
+        for (auto &attempt : attempts) {
+            if (!attempt->pending || !HasOverlappedIoCompleted(&attempt->overlapped)) {
+                continue;
+            }
+
+            --active;
+            int error = attempt->finish();
+            if (error == 0) {
+                co_return std::move(attempt->socket);
+            }
+            last_error = error;
+        }
+
+        if (active == 0) {
+            // Start the next one right away, or give up if there are none left
+            continue;
+        }
+
+        if (aio_clock::now() >= deadline) {
+            // The remaining attempts get cancelled as they go out of scope
+            fail_ws("Timed out connecting to socket", WSAETIMEDOUT);
+        }
+
+        aio_clock::time_point wake = deadline;
+        if (next < addrs.size()) {
+            wake = std::min<aio_clock::time_point>(wake, next_start);
+        }
+
+        co_await event_signaled_until{done, wake};
+    }
+}
+
 OwningSocket Socket::listen(uint16_t port) {
     OwningSocket result = Socket::create();
 
@@ -54,6 +262,80 @@ OwningSocket Socket::listen(uint16_t port) {
     return result;
 }
 
+static sockaddr_un _impl_local_address(const std::string &path) {
+    sockaddr_un result{.sun_family = AF_UNIX};
+
+    // Has to leave room for the null terminator
+    if (path.size() >= sizeof(result.sun_path)) {
+        fail("Local socket path is too long");
+    }
+    std::copy(path.begin(), path.end(), result.sun_path);
+
+    return result;
+}
+
+#ifndef IO_REPARSE_TAG_AF_UNIX
+#define IO_REPARSE_TAG_AF_UNIX 0x80000023L
+#endif
+
+// The socket file outlives its listener, and would make the bind fail. It is only removed if it
+// really is a socket file, and nobody accepts on it anymore; anything else is left for bind to report.
+static void _impl_remove_stale_local(const std::string &path, const sockaddr_un &addr, int type) {
+    WIN32_FIND_DATAA info{};
+    HANDLE search = FindFirstFileA(path.c_str(), &info);
+    if (search == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    FindClose(search);
+
+    // dwReserved0 holds the reparse tag for reparse points
+    if (!(info.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) || info.dwReserved0 != IO_REPARSE_TAG_AF_UNIX) {
+        return;
+    }
+
+    OwningSocket probe = Socket::create(AF_UNIX, type, 0);
+    int status = ::connect(probe.raw(), (const sockaddr *)&addr, sizeof(addr));
+    if (status != SOCKET_ERROR || WSAGetLastError() != WSAECONNREFUSED) {
+        // Still in use, or something we can't tell
+        return;
+    }
+
+    DeleteFileA(path.c_str());
+}
+
+OwningSocket Socket::listen_local(const std::string &path, int type, bool remove_stale) {
+    OwningSocket result = Socket::create(AF_UNIX, type, 0);
+    sockaddr_un addr = _impl_local_address(path);
+
+    if (remove_stale) {
+        _impl_remove_stale_local(path, addr, type);
+    }
+
+    int status = ::bind(result.raw(), (sockaddr *)&addr, sizeof(addr));
+    if (status == SOCKET_ERROR) {
+        fail_ws("Failed to bind socket");
+    }
+
+    status = ::listen(result.raw(), SOMAXCONN);
+    if (status == SOCKET_ERROR) {
+        fail_ws("Failed to listen on socket");
+    }
+
+    return result;
+}
+
+OwningSocket Socket::connect_local(const std::string &path, int type) {
+    OwningSocket result = Socket::create(AF_UNIX, type, 0);
+    sockaddr_un addr = _impl_local_address(path);
+
+    int status = ::connect(result.raw(), (sockaddr *)&addr, sizeof(addr));
+    if (status == SOCKET_ERROR) {
+        fail_ws("Failed to connect to socket");
+    }
+
+    return result;
+}
+
 OwningSocket Socket::accept() {
     return OwningSocket(::accept(raw(), nullptr, nullptr)).validate();
 }
@@ -199,6 +481,281 @@ AIO<eof<size_t>> Socket::write_async_from(std::span<const unsigned char> data) {
     co_return eof((size_t)transmitted, transmitted == 0);
 }
 
+AIO<eof<size_t>> Socket::write_async_gather(std::span<const std::span<const unsigned char>> buffers) {
+    auto &env = *co_await current_env{};
+    WSAOVERLAPPED *overlapped = (WSAOVERLAPPED *)env.overlapped();
+
+    auto wsabufs = std::make_unique<WSABUF[]>(buffers.size());
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        // Note: const violation is okay because WSASend mustn't write to these buffers
+        wsabufs[i] = WSABUF{.len = (ULONG)buffers[i].size(), .buf = (char *)buffers[i].data()};
+    }
+
+    int status = WSASend(
+        raw(),
+        wsabufs.get(),
+        (DWORD)buffers.size(),
+        nullptr,
+        0,
+        overlapped,
+        nullptr
+    );
+
+    if (status == SOCKET_ERROR) {
+        switch (WSAGetLastError()) {
+        case WSA_IO_PENDING:
+            break;
+        case WSAECONNRESET:
+        case WSAEDISCON:
+            co_return eof((size_t)0, true);
+        default:
+            fail_ws("Failed to initiate asynchronous write to socket");
+        }
+    }
+
+    co_await io_done_signaled{};
+
+    DWORD transmitted = 0;
+    DWORD flags = 0;
+    bool success = WSAGetOverlappedResult(
+        raw(),
+        overlapped,
+        &transmitted,
+        false,
+        &flags
+    );
+
+    if (!success) {
+        switch (WSAGetLastError()) {
+        case WSAECONNRESET:
+        case WSAEDISCON:
+            co_return eof((size_t)transmitted, true);
+        default:
+            fail_ws("Failed to get overlapped operation result");
+        }
+    }
+
+    co_return eof((size_t)transmitted, transmitted == 0);
+}
+
+AIO<void> Socket::wait_readable_async() {
+    auto &env = *co_await current_env{};
+    WSAOVERLAPPED *overlapped = (WSAOVERLAPPED *)env.overlapped();
+
+    auto wsadata = std::make_unique<_impl_WSAAsyncData>(std::span<unsigned char>{});
+
+    int status = WSARecv(
+        raw(),
+        &wsadata->wsabuf,
+        1,
+        nullptr,
+        &wsadata->flags,
+        overlapped,
+        nullptr
+    );
+
+    if (status == SOCKET_ERROR) {
+        switch (WSAGetLastError()) {
+        case WSA_IO_PENDING:
+            break;
+        case WSAECONNRESET:
+        case WSAEDISCON:
+            // The following read will report eof
+            co_return;
+        default:
+            fail_ws("Failed to initiate asynchronous wait for socket data");
+        }
+    }
+
+    co_await io_done_signaled{};
+
+    DWORD transmitted = 0;
+    DWORD flags = 0;
+    bool success = WSAGetOverlappedResult(
+        raw(),
+        overlapped,
+        &transmitted,
+        false,
+        &flags
+    );
+
+    if (!success) {
+        switch (WSAGetLastError()) {
+        case WSAECONNRESET:
+        case WSAEDISCON:
+            co_return;
+        default:
+            fail_ws("Failed to get overlapped operation result");
+        }
+    }
+}
+
+AIO<eof<BufferLease>> Socket::read_async_pooled(BufferRing &ring) {
+    co_await wait_readable_async();
+
+    BufferLease lease = co_await ring.borrow_async();
+
+    // There is data already, so this returns right away instead of blocking
+    int read = ::recv(raw(), (char *)lease.capacity().data(), (int)lease.capacity().size(), 0);
+    if (read == SOCKET_ERROR) {
+        switch (WSAGetLastError()) {
+        case WSAECONNRESET:
+        case WSAEDISCON:
+            read = 0;
+            break;
+        default:
+            fail_ws("Failed to read from socket");
+        }
+    }
+
+    lease.resize((size_t)read);
+    co_return eof<BufferLease>{std::move(lease), read == 0};
+}
+
+#pragma region File transfer
+// TransmitFile's limit per call
+static constexpr uint64_t _impl_max_transmit_chunk = 0x7FFFFFFE;
+static constexpr size_t _impl_send_file_buffer = 64 * 1024;
+
+static bool _impl_transmit_unsupported(int error) {
+    switch (error) {
+    case WSAEOPNOTSUPP:
+    case ERROR_NOT_SUPPORTED:
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint64_t Socket::send_file(Handle file, uint64_t offset, uint64_t length) {
+    if (GetFileType(file.raw()) != FILE_TYPE_DISK) {
+        return send_file_fallback(file, offset, length);
+    }
+
+    uint64_t size = file.file_size();
+    if (offset >= size) {
+        return 0;
+    }
+    length = std::min<uint64_t>(length, size - offset);
+
+    PendingIO op{};
+    uint64_t sent = 0;
+    while (sent < length) {
+        DWORD chunk = (DWORD)std::min<uint64_t>(length - sent, _impl_max_transmit_chunk);
+
+        OVERLAPPED *overlapped = op.prepare(io_handle(), offset + sent);
+        // A leftover signal from the previous chunk would make us collect the result too early
+        op.event_done().reset();
+
+        bool success = TransmitFile(raw(), file.raw(), chunk, 0, overlapped, nullptr, 0);
+        if (!success && WSAGetLastError() != ERROR_IO_PENDING) {
+            if (sent == 0 && _impl_transmit_unsupported(WSAGetLastError())) {
+                return send_file_fallback(file, offset, length);
+            }
+            fail_ws("Failed to transmit file");
+        }
+
+        DWORD transmitted = 0;
+        DWORD flags = 0;
+        success = WSAGetOverlappedResult(raw(), (WSAOVERLAPPED *)overlapped, &transmitted, true, &flags);
+        if (!success) {
+            fail_ws("Failed to get overlapped operation result");
+        }
+
+        sent += transmitted;
+        if (transmitted == 0) {
+            break;
+        }
+    }
+
+    return sent;
+}
+
+AIO<uint64_t> Socket::send_file_async(Handle file, uint64_t offset, uint64_t length) {
+    if (GetFileType(file.raw()) != FILE_TYPE_DISK) {
+        co_return co_await send_file_fallback_async(file, offset, length);
+    }
+
+    uint64_t size = file.file_size();
+    if (offset >= size) {
+        co_return 0;
+    }
+    length = std::min<uint64_t>(length, size - offset);
+
+    auto &env = *co_await current_env{};
+
+    uint64_t sent = 0;
+    while (sent < length) {
+        DWORD chunk = (DWORD)std::min<uint64_t>(length - sent, _impl_max_transmit_chunk);
+        OVERLAPPED *overlapped = env.overlapped(offset + sent);
+
+        bool success = TransmitFile(raw(), file.raw(), chunk, 0, overlapped, nullptr, 0);
+        if (!success && WSAGetLastError() != ERROR_IO_PENDING) {
+            if (sent == 0 && _impl_transmit_unsupported(WSAGetLastError())) {
+                co_return co_await send_file_fallback_async(file, offset, length);
+            }
+            fail_ws("Failed to transmit file");
+        }
+
+        co_await io_done_signaled{};
+
+        DWORD transmitted = 0;
+        DWORD flags = 0;
+        success = WSAGetOverlappedResult(raw(), (WSAOVERLAPPED *)overlapped, &transmitted, false, &flags);
+        if (!success) {
+            fail_ws("Failed to get overlapped operation result");
+        }
+
+        sent += transmitted;
+        if (transmitted == 0) {
+            break;
+        }
+    }
+
+    co_return sent;
+}
+
+uint64_t Socket::send_file_fallback(Handle file, uint64_t offset, uint64_t length) {
+    bool seekable = GetFileType(file.raw()) == FILE_TYPE_DISK;
+    auto buf = std::make_unique_for_overwrite<unsigned char[]>(_impl_send_file_buffer);
+
+    uint64_t sent = 0;
+    while (sent < length) {
+        std::span<unsigned char> chunk{buf.get(), (size_t)std::min<uint64_t>(length - sent, _impl_send_file_buffer)};
+
+        eof<size_t> read = seekable ? file.read_at(offset + sent, chunk) : file.read_into(chunk);
+        write_full_from(chunk.first(read.value));
+        sent += read.value;
+
+        if (read.is_eof) {
+            break;
+        }
+    }
+
+    return sent;
+}
+
+AIO<uint64_t> Socket::send_file_fallback_async(Handle file, uint64_t offset, uint64_t length) {
+    bool seekable = GetFileType(file.raw()) == FILE_TYPE_DISK;
+    auto buf = std::make_unique_for_overwrite<unsigned char[]>(_impl_send_file_buffer);
+
+    uint64_t sent = 0;
+    while (sent < length) {
+        std::span<unsigned char> chunk{buf.get(), (size_t)std::min<uint64_t>(length - sent, _impl_send_file_buffer)};
+
+        eof<size_t> read = seekable ? co_await file.read_async_at(offset + sent, chunk) : co_await file.read_async_into(chunk);
+        co_await write_async_full_from(chunk.first(read.value));
+        sent += read.value;
+
+        if (read.is_eof) {
+            break;
+        }
+    }
+
+    co_return sent;
+}
+#pragma endregion File transfer
+
 void Socket::shutdown(int how) {
     int status = ::shutdown(raw(), how);
     if (status == SOCKET_ERROR) {
@@ -206,4 +763,12 @@ void Socket::shutdown(int how) {
     }
 }
 
+void Socket::set_nonblocking(bool nonblocking) {
+    u_long mode = nonblocking;
+    int status = ioctlsocket(raw(), FIONBIO, &mode);
+    if (status == SOCKET_ERROR) {
+        fail_ws("Failed to change socket blocking mode");
+    }
+}
+
 }  // namespace abel
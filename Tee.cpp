@@ -0,0 +1,172 @@
+#include <abel/Tee.hpp>
+
+namespace abel {
+
+Tee Tee::create() {
+    return Tee{std::make_shared<state>()};
+}
+
+Tee::sink_state &Tee::get_sink(size_t sink) const {
+    std::lock_guard lock{shared->mutex};
+
+    if (sink >= shared->sinks.size()) {
+        fail("Invalid tee sink index");
+    }
+
+    return *shared->sinks[sink];
+}
+
+size_t Tee::add_sink(size_t max_lag, lag_policy policy) {
+    std::lock_guard lock{shared->mutex};
+
+    if (shared->closed) {
+        fail("Cannot add a sink to a closed tee");
+    }
+
+    shared->sinks.push_back(std::make_unique<sink_state>(max_lag, policy));
+    return shared->sinks.size() - 1;
+}
+
+void Tee::detach_sink(size_t sink) {
+    sink_state &target = get_sink(sink);
+
+    std::lock_guard lock{shared->mutex};
+
+    target.stats.attached = false;
+    target.stats.dropped_bytes += target.stats.queued_bytes;
+    target.stats.queued_bytes = 0;
+    target.queue.clear();
+    target.wakeup.signal();
+}
+
+Tee::sink_stats Tee::get_sink_stats(size_t sink) const {
+    sink_state &target = get_sink(sink);
+
+    std::lock_guard lock{shared->mutex};
+    return target.stats;
+}
+
+size_t Tee::attached_sinks() const {
+    std::lock_guard lock{shared->mutex};
+
+    size_t result = 0;
+    for (const auto &sink : shared->sinks) {
+        result += sink->stats.attached;
+    }
+    return result;
+}
+
+Tee::chunk_t Tee::next_chunk(state &shared, sink_state &sink, bool &done) {
+    std::lock_guard lock{shared.mutex};
+
+    if (!sink.stats.attached) {
+        done = true;
+        return nullptr;
+    }
+
+    if (!sink.queue.empty()) {
+        return sink.queue.front();
+    }
+
+    if (shared.closed) {
+        done = true;
+        return nullptr;
+    }
+
+    sink.wakeup.reset();
+    return nullptr;
+}
+
+void Tee::chunk_done(state &shared, sink_state &sink, size_t written, bool dst_eof) {
+    std::lock_guard lock{shared.mutex};
+
+    if (!sink.stats.attached) {
+        // Detached while writing; the queue is already gone
+        return;
+    }
+
+    size_t size = sink.queue.front()->size();
+    sink.queue.pop_front();
+    sink.stats.queued_bytes -= size;
+    sink.stats.written_bytes += written;
+
+    if (dst_eof) {
+        sink.stats.attached = false;
+        sink.stats.dropped_bytes += size - written + sink.stats.queued_bytes;
+        sink.stats.queued_bytes = 0;
+        sink.queue.clear();
+    }
+}
+
+eof<size_t> Tee::write_from(std::span<const unsigned char> data) {
+    std::lock_guard lock{shared->mutex};
+
+    if (shared->closed) {
+        fail("Cannot write to a closed tee");
+    }
+
+    if (data.empty()) {
+        return eof((size_t)0, false);
+    }
+
+    chunk_t chunk = nullptr;
+    bool any_attached = false;
+
+    for (auto &sink : shared->sinks) {
+        if (!sink->stats.attached) {
+            continue;
+        }
+
+        // A sink that has caught up always accepts the chunk, even an oversized one
+        if (sink->stats.queued_bytes > 0 && sink->stats.queued_bytes + data.size() > sink->max_lag) {
+            switch (sink->policy) {
+            case lag_policy::drop:
+                sink->stats.dropped_bytes += data.size();
+                any_attached = true;
+                continue;
+
+            case lag_policy::disconnect:
+                sink->stats.attached = false;
+                sink->stats.dropped_bytes += sink->stats.queued_bytes + data.size();
+                sink->stats.queued_bytes = 0;
+                sink->queue.clear();
+                sink->wakeup.signal();
+                continue;
+            }
+        }
+
+        any_attached = true;
+
+        if (!chunk) {
+            chunk = std::make_shared<const std::vector<unsigned char>>(data.begin(), data.end());
+        }
+
+        sink->queue.push_back(chunk);
+        sink->stats.queued_bytes += data.size();
+        if (sink->queue.size() == 1) {
+            // The pump only ever waits on an empty queue
+            sink->wakeup.signal();
+        }
+    }
+
+    if (!any_attached) {
+        return eof((size_t)0, true);
+    }
+
+    return eof(data.size(), false);
+}
+
+AIO<eof<size_t>> Tee::write_async_from(std::span<const unsigned char> data) {
+    co_return write_from(data);
+}
+
+void Tee::close() {
+    std::lock_guard lock{shared->mutex};
+
+    shared->closed = true;
+    for (auto &sink : shared->sinks) {
+        sink->wakeup.signal();
+    }
+}
+
+}  // namespace abel
@@ -0,0 +1,168 @@
+#include <abel/WriteQueue.hpp>
+
+#include <bit>
+#include <algorithm>
+
+namespace abel {
+
+#pragma region latency_histogram
+void latency_histogram::record(aio_clock::duration latency) noexcept {
+    uint64_t us = (uint64_t)std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count(), 0);
+    size_t bucket = std::min<size_t>(std::bit_width(us), bucket_count - 1);
+    ++buckets[bucket];
+    ++total;
+}
+
+aio_clock::duration latency_histogram::percentile(double fraction) const noexcept {
+    uint64_t target = (uint64_t)(fraction * total);
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < bucket_count; ++i) {
+        seen += buckets[i];
+        if (seen > target || (seen == total && seen > 0)) {
+            // Bucket i holds values below 2^i microseconds
+            return std::chrono::microseconds(1ull << i);
+        }
+    }
+
+    return aio_clock::duration{};
+}
+#pragma endregion latency_histogram
+
+#pragma region WriteQueue
+WriteQueue::WriteQueue(Socket socket, write_queue_options options) :
+    socket{socket}, options{options} {
+
+    this->options.max_batch_messages = std::clamp<size_t>(this->options.max_batch_messages, 1, 1024);
+}
+
+bool WriteQueue::push(std::span<const unsigned char> data) {
+    if (closed) {
+        fail("Write queue is closed");
+    }
+
+    if (broken) {
+        return false;
+    }
+
+    if (!queue.empty() && queued_bytes_ + data.size() > options.max_queued_bytes) {
+        ++stats_.refused;
+        has_room.reset();
+        return false;
+    }
+
+    queue.push_back(message{{data.begin(), data.end()}, aio_clock::now()});
+    queued_bytes_ += data.size();
+
+    has_data.signal();
+    if (queued_bytes_ >= options.max_batch_bytes) {
+        batch_full.signal();
+    }
+
+    return true;
+}
+
+AIO<void> WriteQueue::push_async(std::span<const unsigned char> data) {
+    while (!push(data)) {
+        if (broken) {
+            fail("Connection broke with writes still queued");
+        }
+        co_await event_signaled{has_room};
+    }
+}
+
+void WriteQueue::close() {
+    closed = true;
+    // Nothing to wait for anymore
+    has_data.signal();
+    batch_full.signal();
+}
+
+void WriteQueue::consume(size_t sent) {
+    aio_clock::time_point now = aio_clock::now();
+    queued_bytes_ -= sent;
+    stats_.bytes += sent;
+
+    while (sent > 0) {
+        message &front = queue.front();
+        size_t left = front.data.size() - front_offset;
+
+        if (sent < left) {
+            front_offset += sent;
+            break;
+        }
+
+        sent -= left;
+        stats_.latency.record(now - front.queued);
+        ++stats_.messages;
+        queue.pop_front();
+        front_offset = 0;
+    }
+
+    // Empty messages take no bytes, but are still done once they reach the front
+    while (!queue.empty() && queue.front().data.empty()) {
+        stats_.latency.record(now - queue.front().queued);
+        ++stats_.messages;
+        queue.pop_front();
+    }
+
+    if (queued_bytes_ < options.max_queued_bytes) {
+        has_room.signal();
+    }
+    if (queued_bytes_ < options.max_batch_bytes && !closed) {
+        batch_full.reset();
+    }
+}
+
+AIO<void> WriteQueue::run() {
+    std::vector<std::span<const unsigned char>> batch{};
+
+    while (true) {
+        if (queue.empty()) {
+            if (closed) {
+                co_return;
+            }
+            has_data.reset();
+            co_await event_signaled{has_data};
+            continue;
+        }
+
+        if (options.flush_delay > aio_clock::duration{} && !closed && queued_bytes_ < options.max_batch_bytes) {
+            // Give the producers a chance to add more, counting from the oldest message
+            co_await event_signaled_until{batch_full, queue.front().queued + options.flush_delay};
+        }
+
+        batch.clear();
+        size_t batch_bytes = 0;
+        for (size_t i = 0; i < queue.size() && batch.size() < options.max_batch_messages; ++i) {
+            std::span<const unsigned char> data = queue[i].data;
+            if (i == 0) {
+                data = data.subspan(front_offset);
+            }
+
+            if (i > 0 && batch_bytes + data.size() > options.max_batch_bytes) {
+                break;
+            }
+            batch.push_back(data);
+            batch_bytes += data.size();
+        }
+
+        // Pushes while this is in flight don't move the queued data, so the spans stay valid
+        eof<size_t> result = co_await socket.write_async_gather(batch);
+        ++stats_.sends;
+        consume(result.value);
+
+        if (result.is_eof && batch_bytes > 0) {
+            broken = true;
+            queue.clear();
+            queued_bytes_ = 0;
+            front_offset = 0;
+            // Wake up anyone waiting for room, so that they notice
+            has_room.signal();
+            co_return;
+        }
+    }
+}
+#pragma endregion WriteQueue
+
+}  // namespace abel
@@ -0,0 +1,65 @@
+#include <abel/ZeroCopy.hpp>
+
+namespace abel {
+
+ZeroCopySocket::ZeroCopySocket(Socket socket, size_t threshold, zero_copy_stats *stats) :
+    socket_{socket}, threshold{threshold}, stats{stats} {
+
+    int size = 0;
+    int length = sizeof(size);
+    int status = getsockopt(socket_.raw(), SOL_SOCKET, SO_SNDBUF, (char *)&size, &length);
+    if (status == SOCKET_ERROR) {
+        fail_ws("Failed to get socket send buffer size");
+    }
+    enabled = size == 0;
+}
+
+void ZeroCopySocket::enable() {
+    if (enabled) {
+        return;
+    }
+
+    int size = 0;
+    int status = setsockopt(socket_.raw(), SOL_SOCKET, SO_SNDBUF, (const char *)&size, sizeof(size));
+    if (status == SOCKET_ERROR) {
+        fail_ws("Failed to set socket send buffer size");
+    }
+    enabled = true;
+}
+
+void ZeroCopySocket::record(size_t size, bool zero_copy) noexcept {
+    if (!stats) {
+        return;
+    }
+
+    if (zero_copy) {
+        ++stats->zero_copy_writes;
+        stats->zero_copy_bytes += size;
+    } else {
+        ++stats->copied_writes;
+        stats->copied_bytes += size;
+    }
+}
+
+eof<size_t> ZeroCopySocket::write_from(std::span<const unsigned char> data) {
+    if (wants_zero_copy(data.size())) {
+        enable();
+    }
+
+    eof<size_t> result = socket_.write_from(data);
+    record(result.value, enabled);
+    return result;
+}
+
+AIO<eof<size_t>> ZeroCopySocket::write_async_from(std::span<const unsigned char> data) {
+    if (wants_zero_copy(data.size())) {
+        enable();
+    }
+
+    // In zero-copy mode, the overlapped send only completes once the stack no longer needs the pages
+    eof<size_t> result = co_await socket_.write_async_from(data);
+    record(result.value, enabled);
+    co_return result;
+}
+
+}  // namespace abel
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/IOBase.hpp>
+#include <abel/Concurrency.hpp>
+#include <abel/MemoryStream.hpp>
+
+#include <chrono>
+#include <cstdint>
+
+namespace abel {
+
+struct bench_result {
+    uint64_t operations = 0;
+    uint64_t bytes = 0;
+    aio_clock::duration elapsed{};
+
+    aio_clock::duration per_operation() const noexcept {
+        return operations ? elapsed / operations : aio_clock::duration{};
+    }
+
+    double bytes_per_second() const noexcept {
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        return seconds > 0 ? (double)bytes / seconds : 0;
+    }
+};
+
+struct bench_options {
+    uint64_t operations = 100'000;
+    size_t chunk_size = 4096;
+    // Passed on to FaultInjecting, to split every call into pieces of at most this many bytes. 0 leaves them whole
+    size_t max_read = 0;
+    size_t max_write = 0;
+    // Run untimed first, so that caches and the allocator are warmed up
+    uint64_t warmup = 1000;
+};
+
+// Benchmarks of the IOBase helpers and the coroutine machinery over MemoryStream, so that they measure
+// the library alone rather than the kernel. Everything runs on the calling thread, and apart from the
+// timings themselves the runs are deterministic: FaultInjecting splits the calls the same way every time.
+// An operation is a single call of the helper being measured, on chunk_size bytes.
+
+// read_full_into on chunks written in advance, untimed
+bench_result bench_read_full(const bench_options &options = {});
+
+// write_async_full_from, including the AIO it is awaited through. The data is drained untimed
+bench_result bench_write_async_full(const bench_options &options = {});
+
+// async_transfer between two MemoryStream pairs, with the producer and consumer tasks running alongside.
+// max_read applies to the transfer's source, max_write to its destination
+bench_result bench_async_transfer(const bench_options &options = {});
+
+// co_await on an AIO that completes without suspending, i.e. the cost of the coroutine frame and
+// the handoff alone. Only operations and warmup apply
+bench_result bench_coroutine(const bench_options &options = {});
+
+}  // namespace abel
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <Windows.h>
+#include <span>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <algorithm>
+
+namespace abel {
+
+class BufferRing;
+
+struct buffer_ring_stats {
+    size_t buffer_size = 0;
+    size_t capacity = 0;
+    size_t in_use = 0;
+    size_t peak_in_use = 0;
+    uint64_t borrows = 0;
+    // Borrows that found the ring empty and had to wait
+    uint64_t exhausted = 0;
+
+    // Memory actually holding data right now
+    size_t bytes_in_use() const noexcept {
+        return in_use * buffer_size;
+    }
+};
+
+// A buffer borrowed from a BufferRing. Goes back to the ring once destroyed. The ring must outlive it.
+class BufferLease {
+protected:
+    friend BufferRing;
+
+    BufferRing *ring = nullptr;
+    uint32_t idx = 0;
+    std::span<unsigned char> buf{};
+    size_t size_ = 0;
+
+    BufferLease(BufferRing *ring, uint32_t idx, std::span<unsigned char> buf) :
+        ring{ring}, idx{idx}, buf{buf} {
+    }
+
+public:
+    BufferLease() = default;
+
+    BufferLease(const BufferLease &other) = delete;
+    BufferLease &operator=(const BufferLease &other) = delete;
+
+    BufferLease(BufferLease &&other) noexcept :
+        ring{std::exchange(other.ring, nullptr)}, idx{other.idx}, buf{other.buf}, size_{other.size_} {
+    }
+
+    BufferLease &operator=(BufferLease &&other) noexcept {
+        std::swap(ring, other.ring);
+        std::swap(idx, other.idx);
+        std::swap(buf, other.buf);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+
+    ~BufferLease() noexcept;
+
+    constexpr operator bool() const noexcept {
+        return ring != nullptr;
+    }
+
+    // The whole buffer, to be filled
+    constexpr std::span<unsigned char> capacity() const noexcept {
+        return buf;
+    }
+
+    // The filled part
+    constexpr std::span<unsigned char> data() const noexcept {
+        return buf.first(size_);
+    }
+
+    constexpr size_t size() const noexcept {
+        return size_;
+    }
+
+    void resize(size_t size) {
+        if (size > buf.size()) {
+            fail("Buffer lease overflow");
+        }
+        size_ = size;
+    }
+};
+
+// A fixed set of equally sized buffers, shared by many connections, which only borrow one once
+// they actually have data to put in it, the way kernel-provided buffer rings work. Memory then
+// scales with the number of connections that are active at the same time, not with the total.
+// Buffers are handed out most recently returned first, so that the working set stays small.
+// The free list isn't locked, so all borrowing and returning has to happen on one thread.
+class BufferRing {
+protected:
+    friend BufferLease;
+
+    size_t buffer_size;
+    size_t count;
+    std::unique_ptr<unsigned char[]> storage;
+    std::vector<uint32_t> free_list{};
+    // Signaled while there are free buffers
+    OwningHandle available = Handle::create_event(true, true);
+    buffer_ring_stats stats_{};
+
+    void give_back(uint32_t idx) noexcept;
+
+public:
+    BufferRing(size_t buffer_size, size_t count);
+
+    BufferRing(const BufferRing &other) = delete;
+    BufferRing &operator=(const BufferRing &other) = delete;
+
+    std::optional<BufferLease> try_borrow();
+
+    // Waits for a buffer to be returned if there are none left
+    AIO<BufferLease> borrow_async();
+
+    buffer_ring_stats stats() const noexcept;
+};
+
+}  // namespace abel
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <abel/IOBase.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <span>
+#include <cstdint>
+#include <utility>
+
+namespace abel {
+
+// Incremental CRC-32C (Castagnoli). Uses the SSE4.2 crc32 instruction when the CPU supports it,
+// and a slicing-by-8 table implementation otherwise.
+class Crc32c {
+protected:
+    uint32_t state = 0xFFFFFFFF;
+
+public:
+    constexpr Crc32c() noexcept = default;
+
+    void update(std::span<const unsigned char> data) noexcept;
+
+    constexpr uint32_t value() const noexcept {
+        return ~state;
+    }
+
+    constexpr void reset() noexcept {
+        state = 0xFFFFFFFF;
+    }
+
+    static uint32_t compute(std::span<const unsigned char> data) noexcept {
+        Crc32c result{};
+        result.update(data);
+        return result.value();
+    }
+
+    // Tells whether update() is backed by hardware instructions on this machine
+    static bool hardware_accelerated() noexcept;
+};
+
+// Wraps a stream and accumulates a CRC-32C of everything read from and written to it.
+// Like Handle and Socket, this is a non-owning view: the accumulators must outlive it,
+// which is what allows passing it by value into helpers such as async_transfer.
+// Either accumulator may be null to skip checksumming that direction.
+template <typename T>
+class Checksummed : public IOBase {
+protected:
+    T stream;
+    Crc32c *read_crc = nullptr;
+    Crc32c *write_crc = nullptr;
+
+public:
+    Checksummed(T stream, Crc32c *read_crc, Crc32c *write_crc = nullptr) :
+        stream{std::move(stream)}, read_crc{read_crc}, write_crc{write_crc} {
+    }
+
+    Checksummed(const Checksummed &) = default;
+    Checksummed &operator=(const Checksummed &) = default;
+    Checksummed(Checksummed &&) = default;
+    Checksummed &operator=(Checksummed &&) = default;
+
+    template <typename Self>
+    constexpr auto &inner(this Self &self) {
+        return self.stream;
+    }
+
+    eof<size_t> read_into(std::span<unsigned char> data)
+        requires sync_readable<T>
+    {
+        eof<size_t> result = stream.read_into(data);
+        if (read_crc) {
+            read_crc->update(data.first(result.value));
+        }
+        return result;
+    }
+
+    eof<size_t> write_from(std::span<const unsigned char> data)
+        requires sync_writable<T>
+    {
+        eof<size_t> result = stream.write_from(data);
+        if (write_crc) {
+            write_crc->update(data.first(result.value));
+        }
+        return result;
+    }
+
+    AIO<eof<size_t>> read_async_into(std::span<unsigned char> data)
+        requires async_readable<T>
+    {
+        eof<size_t> result = co_await stream.read_async_into(data);
+        if (read_crc) {
+            read_crc->update(data.first(result.value));
+        }
+        co_return result;
+    }
+
+    AIO<eof<size_t>> write_async_from(std::span<const unsigned char> data)
+        requires async_writable<T>
+    {
+        eof<size_t> result = co_await stream.write_async_from(data);
+        if (write_crc) {
+            write_crc->update(data.first(result.value));
+        }
+        co_return result;
+    }
+};
+
+}  // namespace abel
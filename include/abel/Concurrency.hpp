@@ -12,6 +12,11 @@
 #include <concepts>
 #include <cassert>
 #include <memory>
+#include <cstdint>
+#include <chrono>
+#include <optional>
+#include <mutex>
+#include <unordered_map>
 
 namespace abel {
 
@@ -78,11 +83,72 @@ struct event_signaled {
     Handle event;
 };
 
+// The clock that drives AIO timers
+using aio_clock = std::chrono::steady_clock;
+
+// Suspends the coroutine until the deadline. No kernel objects are involved:
+// the scheduler just shortens its wait accordingly, so sleeping coroutines cost nothing.
+// Note: the actual wakeup is subject to the system timer resolution.
+struct sleep_until {
+    aio_clock::time_point deadline;
+};
+
+struct sleep_for {
+    aio_clock::duration duration;
+};
+
+// Like event_signaled, but gives up at the deadline. Resumes with whether the event got signaled.
+// Note: do not use auto-reset events here either!
+struct event_signaled_until {
+    Handle event;
+    aio_clock::time_point deadline;
+};
+
+// A standalone overlapped operation with its own completion event. Allows a single AIO to keep
+// several operations in flight: start each one on its own PendingIO, then co_await event_signaled
+// on their events. Must stay in place while the operation is running, so it is non-movable.
+// If destroyed while still pending, the operation is cancelled and waited for.
+class PendingIO {
+protected:
+    OwningHandle done_ = Handle::create_event(true, false);
+    OVERLAPPED overlapped_{.hEvent = done_.raw()};
+    Handle target_ = nullptr;
+
+public:
+    PendingIO() = default;
+
+    PendingIO(const PendingIO &other) = delete;
+    PendingIO &operator=(const PendingIO &other) = delete;
+    PendingIO(PendingIO &&other) = delete;
+    PendingIO &operator=(PendingIO &&other) = delete;
+
+    ~PendingIO() noexcept;
+
+    // Prepares the operation for a new request against `target` at the given file offset
+    OVERLAPPED *prepare(Handle target, uint64_t offset = 0) noexcept;
+
+    Handle event_done() const noexcept {
+        return done_;
+    }
+
+    bool is_done() const noexcept {
+        return HasOverlappedIoCompleted(&overlapped_);
+    }
+
+    // Returns the number of bytes transferred, blocking until completion if necessary.
+    // Reading at or past the end of a file yields eof.
+    eof<size_t> result();
+
+    // Requests cancellation and waits for the operation to finish
+    void cancel() noexcept;
+};
+
 class AIOEnv {
 protected:
     OwningHandle io_done_ = Handle::create_event(true, true);  // TODO: Different flags?
     OVERLAPPED overlapped_{.hEvent = io_done_.raw()};
     Handle non_io_event_ = nullptr;
+    std::optional<aio_clock::time_point> deadline_{};
     std::coroutine_handle<> current_{nullptr};
 
 public:
@@ -107,7 +173,10 @@ public:
         return io_done_;
     }
 
-    OVERLAPPED *overlapped() noexcept {
+    // Note: the offset only matters for seekable handles, and is reset on every call
+    OVERLAPPED *overlapped(uint64_t offset = 0) noexcept {
+        overlapped_.Offset = (DWORD)(offset & 0xFFFFFFFF);
+        overlapped_.OffsetHigh = (DWORD)(offset >> 32);
         return &overlapped_;
     }
 
@@ -115,6 +184,23 @@ public:
         non_io_event_ = event;
     }
 
+    // Whether an operation started on our OVERLAPPED hasn't completed yet
+    bool io_pending() const noexcept {
+        return !HasOverlappedIoCompleted(&overlapped_);
+    }
+
+    const std::optional<aio_clock::time_point> &deadline() const noexcept {
+        return deadline_;
+    }
+
+    void set_deadline(aio_clock::time_point deadline) noexcept {
+        deadline_ = deadline;
+    }
+
+    void clear_deadline() noexcept {
+        deadline_.reset();
+    }
+
     std::coroutine_handle<> current() const noexcept {
         return current_;
     }
@@ -242,6 +328,60 @@ public:
             return Awaiter{env, event.event};
         }
 
+        auto await_transform(sleep_until sleep) {
+            struct Awaiter {
+                AIOEnv *env;
+                aio_clock::time_point deadline;
+
+                bool await_ready() noexcept {
+                    return aio_clock::now() >= deadline;
+                }
+
+                void await_suspend(coroutine_ptr coro) {
+                    // Just to verify we are the current coroutine
+                    env->update_current(coro, coro);
+                    env->set_deadline(deadline);
+                }
+
+                void await_resume() {
+                }
+            };
+
+            return Awaiter{env, sleep.deadline};
+        }
+
+        auto await_transform(event_signaled_until wait) {
+            struct Awaiter {
+                AIOEnv *env;
+                Handle event;
+                aio_clock::time_point deadline;
+
+                bool await_ready() {
+                    return event.is_signaled() || aio_clock::now() >= deadline;
+                }
+
+                void await_suspend(coroutine_ptr coro) {
+                    // Just to verify we are the current coroutine
+                    env->update_current(coro, coro);
+                    env->set_non_io_event(event);
+                    env->set_deadline(deadline);
+                }
+
+                bool await_resume() {
+                    // Whichever of the two woke us up, the other one must not linger
+                    env->set_non_io_event(nullptr);
+                    env->clear_deadline();
+                    return event.is_signaled();
+                }
+            };
+
+            return Awaiter{env, wait.event, wait.deadline};
+        }
+
+        auto await_transform(sleep_for sleep) {
+            return await_transform(sleep_until{aio_clock::now() + sleep.duration});
+        }
+
         decltype(auto) await_transform(auto &&x) {
             return std::forward<decltype(x)>(x);
         }
@@ -340,6 +480,7 @@ public:
         return std::forward<Self>(self);
     }
 
+    // Waits for any task to become ready, but no longer than `miliseconds` or the nearest task deadline
     void wait_any(DWORD miliseconds = INFINITE);
 
     void step();
@@ -347,6 +488,79 @@ public:
     bool done() const;
 
     void run();
+
+    // Same as run, but gives up at the deadline. Returns whether everything finished by then
+    bool run_until(aio_clock::time_point deadline);
+};
+
+// An open-ended set of tasks, for when ParallelAIOs' fixed set and its MAXIMUM_WAIT_OBJECTS limit
+// won't do, e.g. with a task per connection. Each task's wait is handed to the system thread pool,
+// which multiplexes them over a completion port, so only the tasks whose event fired or whose
+// deadline passed get stepped. Tasks may add more tasks; everything else belongs to the running thread.
+class TaskSet {
+protected:
+    struct entry {
+        TaskSet *owner;
+        uint64_t id;
+        // Declared before the task, so that it outlives the coroutine frame
+        AIOEnv env{};
+        AIO<void> task;
+        PTP_WAIT wait = nullptr;
+
+        entry(TaskSet *owner, uint64_t id, AIO<void> task);
+
+        entry(const entry &other) = delete;
+        entry &operator=(const entry &other) = delete;
+
+        ~entry() noexcept;
+    };
+
+    std::unordered_map<uint64_t, std::unique_ptr<entry>> entries{};
+    uint64_t next_id = 0;
+
+    // Filled in by the thread pool callbacks
+    std::mutex ready_mutex{};
+    std::vector<uint64_t> ready_ids{};
+    OwningHandle ready = Handle::create_event(false, false);
+
+    static void CALLBACK on_wait(PTP_CALLBACK_INSTANCE instance, void *context, PTP_WAIT wait, TP_WAIT_RESULT result);
+
+    // Thread-safe
+    void schedule(uint64_t id);
+
+    // Registers the wait for whatever the task is suspended on
+    void arm(entry &target);
+
+    void step_ready();
+
+public:
+    TaskSet() = default;
+
+    TaskSet(const TaskSet &other) = delete;
+    TaskSet &operator=(const TaskSet &other) = delete;
+
+    // Destroys the tasks that are still running
+    ~TaskSet() noexcept;
+
+    void add(AIO<void> task);
+
+    size_t size() const noexcept {
+        return entries.size();
+    }
+
+    bool empty() const noexcept {
+        return entries.empty();
+    }
+
+    // Runs until every task is done, or until the event is signaled if there is one
+    void run(Handle stop = nullptr);
+
+    // Same as run, but gives up at the deadline. Returns whether everything finished by then
+    bool run_until(aio_clock::time_point deadline);
+
+    // Destroys the remaining tasks without running them any further.
+    // Blocks until whatever IO they have pending completes, so it should be cancelled first
+    void clear() noexcept;
 };
 
 }  // namespace abel
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/Socket.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <WinSock2.h>
+#include <Windows.h>
+#include <map>
+#include <vector>
+#include <cstdint>
+
+namespace abel {
+
+struct drain_stats {
+    // Connections that finished on their own after draining started
+    uint64_t drained = 0;
+    // Connections still open at the deadline, and closed with a reset
+    uint64_t aborted = 0;
+    // From the start of draining until the last connection was gone
+    aio_clock::duration drain_time{};
+};
+
+class PendingAccept;
+class ConnectionDrainer;
+
+// Registration of a single connection with a ConnectionDrainer, held by the task serving it
+class DrainTicket {
+protected:
+    friend class ConnectionDrainer;
+
+    ConnectionDrainer *owner = nullptr;
+    uint64_t id = 0;
+
+    DrainTicket(ConnectionDrainer *owner, uint64_t id) noexcept :
+        owner{owner}, id{id} {
+    }
+
+public:
+    DrainTicket() = default;
+
+    DrainTicket(const DrainTicket &other) = delete;
+    DrainTicket &operator=(const DrainTicket &other) = delete;
+
+    DrainTicket(DrainTicket &&other) noexcept;
+    DrainTicket &operator=(DrainTicket &&other) noexcept;
+
+    ~DrainTicket() noexcept;
+
+    bool draining() const noexcept;
+
+    // Marks the connection as waiting for the peer, with nothing of its own to send.
+    // Idle connections get half-closed as soon as draining starts.
+    void set_idle(bool idle) noexcept;
+
+    // Half-closes the connection (shutdown(SD_SEND)) once everything has been written,
+    // so that the peer sees a clean end of stream. Reading may continue until the peer closes too.
+    void finish() noexcept;
+};
+
+// Lets a server shut down without dropping what is in flight. Draining stops all registered
+// accepts, half-closes the idle connections right away and leaves the busy ones to finish
+// their current exchange and half-close themselves; whatever is still open at the deadline
+// is aborted: its pending IO is cancelled and the socket is set to close with a reset.
+// Tickets update it directly, so a multithreaded server needs one per thread, like ShardedListener has per shard.
+class ConnectionDrainer {
+protected:
+    friend class DrainTicket;
+
+    struct connection {
+        Socket socket;
+        bool idle = false;
+        bool finished = false;
+    };
+
+    std::map<uint64_t, connection> connections{};
+    uint64_t next_id = 0;
+    std::vector<PendingAccept *> acceptors{};
+    bool draining_ = false;
+    aio_clock::time_point drain_start{};
+    drain_stats stats_{};
+
+    void release(uint64_t id) noexcept;
+
+    static void finish(connection &conn) noexcept;
+
+public:
+    // How long servers give their connections to finish by default
+    static constexpr aio_clock::duration default_timeout = std::chrono::seconds(5);
+
+    // How long the tasks of aborted connections get to unwind after their IO is cancelled.
+    // A task still running after that is destroyed where it stands, so handlers shouldn't
+    // start IO on other handles once their connection is gone.
+    static constexpr aio_clock::duration unwind_timeout = std::chrono::seconds(1);
+
+    ConnectionDrainer() = default;
+
+    ConnectionDrainer(const ConnectionDrainer &other) = delete;
+    ConnectionDrainer &operator=(const ConnectionDrainer &other) = delete;
+
+    // The accept gets stopped once draining starts. It must outlive the drainer
+    void add_acceptor(PendingAccept &accept);
+
+    // The connection stays registered for as long as the ticket lives
+    DrainTicket track(Socket socket);
+
+    // Stops accepting, and half-closes the idle connections
+    void begin_drain();
+
+    // Aborts the connections still open. Their tasks still have to be stepped to wind down
+    void abort_remaining() noexcept;
+
+    // The whole sequence for a server whose connections are served by the given tasks: begins
+    // draining, runs the tasks until the deadline, then aborts the remaining connections and lets
+    // their tasks unwind for up to unwind_timeout. The set is left empty.
+    void drain(TaskSet &tasks, aio_clock::time_point deadline);
+
+    constexpr bool draining() const noexcept {
+        return draining_;
+    }
+
+    size_t active() const noexcept {
+        return connections.size();
+    }
+
+    constexpr const drain_stats &stats() const noexcept {
+        return stats_;
+    }
+};
+
+}  // namespace abel
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/Socket.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <WinSock2.h>
+#include <Windows.h>
+#include <map>
+#include <deque>
+#include <string>
+#include <chrono>
+#include <compare>
+#include <cstdint>
+#include <utility>
+
+namespace abel {
+
+struct connection_pool_options {
+    // Per (host, port)
+    size_t max_idle = 8;
+    // Per (host, port), counting both idle and checked out connections
+    size_t max_total = 32;
+    // Idle connections older than this are closed instead of being reused
+    aio_clock::duration idle_timeout = std::chrono::seconds(60);
+};
+
+struct connection_pool_stats {
+    uint64_t checkouts = 0;
+    // Checkouts served by an idle connection
+    uint64_t reused = 0;
+    // Checkouts that had to connect
+    uint64_t created = 0;
+    // Checkouts that had to wait for max_total to allow them through
+    uint64_t waited = 0;
+    uint64_t timeouts = 0;
+    // Idle connections that failed the liveness check
+    uint64_t broken = 0;
+    // Idle connections closed for being unused for too long
+    uint64_t evicted = 0;
+    aio_clock::duration total_checkout_latency{};
+    aio_clock::duration max_checkout_latency{};
+
+    double reuse_ratio() const noexcept {
+        return checkouts ? (double)reused / checkouts : 0;
+    }
+
+    aio_clock::duration average_checkout_latency() const noexcept {
+        uint64_t succeeded = reused + created;
+        return succeeded ? total_checkout_latency / succeeded : aio_clock::duration{};
+    }
+};
+
+class ConnectionPool;
+
+// A connection checked out of a ConnectionPool. Goes back to the pool once destroyed,
+// unless discarded. The pool must outlive it.
+class PooledSocket {
+protected:
+    friend ConnectionPool;
+
+    ConnectionPool *pool = nullptr;
+    std::string host{};
+    uint16_t port = 0;
+    OwningSocket socket_{};
+
+    PooledSocket(ConnectionPool *pool, std::string host, uint16_t port, OwningSocket socket) :
+        pool{pool}, host{std::move(host)}, port{port}, socket_{std::move(socket)} {
+    }
+
+public:
+    PooledSocket() = default;
+
+    PooledSocket(const PooledSocket &other) = delete;
+    PooledSocket &operator=(const PooledSocket &other) = delete;
+
+    PooledSocket(PooledSocket &&other) noexcept :
+        pool{std::exchange(other.pool, nullptr)},
+        host{std::move(other.host)},
+        port{other.port},
+        socket_{std::move(other.socket_)} {
+    }
+
+    PooledSocket &operator=(PooledSocket &&other) noexcept {
+        std::swap(pool, other.pool);
+        std::swap(host, other.host);
+        std::swap(port, other.port);
+        std::swap(socket_, other.socket_);
+        return *this;
+    }
+
+    ~PooledSocket() noexcept;
+
+    Socket socket() const noexcept {
+        return socket_.borrow();
+    }
+
+    Socket *operator->() noexcept {
+        return &socket_;
+    }
+
+    // Closes the connection instead of returning it, e.g. after an error left it in an unknown state
+    void discard() noexcept;
+};
+
+// A pool of outbound connections, keyed by (host, port). Connections are handed out most recently
+// used first, after checking that the peer has not closed them in the meantime.
+// The buckets are unsynchronized, so leases must be checked out and returned on the pool's thread.
+class ConnectionPool {
+protected:
+    friend PooledSocket;
+
+    struct key {
+        std::string host;
+        uint16_t port;
+
+        auto operator<=>(const key &other) const = default;
+    };
+
+    struct idle_connection {
+        OwningSocket socket;
+        aio_clock::time_point since;
+    };
+
+    struct bucket {
+        std::deque<idle_connection> idle{};
+        // Idle and checked out ones together
+        size_t total = 0;
+    };
+
+    connection_pool_options options;
+    connection_pool_stats stats_{};
+    std::map<key, bucket> buckets{};
+    // Signaled whenever a connection comes back or a slot frees up
+    OwningHandle released = Handle::create_event(true, false);
+
+    // Tells if the connection still seems usable. Idle connections aren't supposed to have
+    // anything to read, so readability means the peer has closed it (or broke the protocol).
+    static bool is_alive(Socket socket);
+
+    void release(const key &k, OwningSocket socket, bool reusable) noexcept;
+
+    void record_latency(aio_clock::time_point start) noexcept;
+
+public:
+    explicit ConnectionPool(connection_pool_options options = {}) :
+        options{options} {
+    }
+
+    ConnectionPool(const ConnectionPool &other) = delete;
+    ConnectionPool &operator=(const ConnectionPool &other) = delete;
+
+    // Reuses an idle connection if there is one, otherwise connects, or waits for one to be released
+    // if the key is at max_total. Fails if that takes past the deadline.
+    AIO<PooledSocket> checkout_async(std::string host, uint16_t port, aio_clock::time_point deadline);
+
+    // Closes idle connections past idle_timeout. Also done on every checkout.
+    void evict_idle();
+
+    size_t idle_count() const noexcept;
+
+    constexpr const connection_pool_stats &stats() const noexcept {
+        return stats_;
+    }
+};
+
+}  // namespace abel
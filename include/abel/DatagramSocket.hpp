@@ -0,0 +1,161 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/Socket.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#include <MSWSock.h>
+#include <Windows.h>
+#include <span>
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <algorithm>
+
+namespace abel {
+
+// An IPv4 or IPv6 address together with a port
+struct endpoint {
+    sockaddr_storage storage{};
+    int length = 0;
+
+    // Picks the first address the host resolves to. Note: blocking
+    static endpoint resolve(const std::string &host, uint16_t port, int family = AF_UNSPEC);
+
+    // The wildcard address of the family
+    static endpoint any(uint16_t port, int family = AF_INET);
+
+    sockaddr *raw() noexcept {
+        return (sockaddr *)&storage;
+    }
+
+    const sockaddr *raw() const noexcept {
+        return (const sockaddr *)&storage;
+    }
+
+    int family() const noexcept {
+        return storage.ss_family;
+    }
+
+    uint16_t port() const noexcept;
+};
+
+struct received_datagram {
+    // With receive offload enabled, this may hold several datagrams from the same sender
+    // back to back, each of them segment_size long except possibly the last
+    std::span<unsigned char> data{};
+    size_t segment_size = 0;
+    endpoint from{};
+    // The datagram didn't fit into the buffer, and the rest of it was discarded
+    bool truncated = false;
+
+    size_t segments() const noexcept {
+        return segment_size ? (data.size() + segment_size - 1) / segment_size : 0;
+    }
+
+    std::span<unsigned char> segment(size_t idx) const noexcept {
+        size_t offset = idx * segment_size;
+        return data.subspan(offset, std::min<size_t>(segment_size, data.size() - offset));
+    }
+};
+
+// A UDP socket. Unlike Socket, this is message-oriented, and every datagram carries its own address.
+// The batch methods move many datagrams per system call: on Windows versions that support them,
+// UDP segmentation offload (USO) sends a run of equally sized datagrams to the same destination in one go,
+// and receive offload (URO) hands over several queued datagrams from the same sender at once.
+class DatagramSocket {
+protected:
+    // Per offloaded send, to stay within the limits of a single IP packet before segmentation
+    static constexpr size_t max_send_offload = 65000;
+    static constexpr size_t max_send_offload_count = 64;
+
+    OwningSocket socket_{};
+    LPFN_WSARECVMSG recv_msg = nullptr;
+    bool send_offload = false;
+    DWORD recv_offload = 0;
+
+    explicit DatagramSocket(OwningSocket socket);
+
+    size_t send_offloaded(std::span<const std::span<const unsigned char>> payloads, const endpoint &to);
+
+    // Returns nothing if the socket is in non-blocking mode and nothing is queued
+    std::optional<received_datagram> recv_msg_sync(std::span<unsigned char> data);
+
+    // The batch receive slot size, validated against the buffers
+    size_t batch_slot(std::span<unsigned char> buffer, std::span<received_datagram> out, size_t max_datagram) const;
+
+    // Receives into consecutive slots for as long as something is queued. The socket is switched to
+    // non-blocking mode for the duration, so that running dry costs one failed receive rather than
+    // a FIONREAD query before every datagram.
+    size_t recv_queued(std::span<unsigned char> buffer, std::span<received_datagram> out, size_t slot);
+
+public:
+    DatagramSocket() = default;
+
+    DatagramSocket(const DatagramSocket &) = delete;
+    DatagramSocket &operator=(const DatagramSocket &) = delete;
+    DatagramSocket(DatagramSocket &&) = default;
+    DatagramSocket &operator=(DatagramSocket &&) = default;
+
+    // An unbound socket, e.g. for sending only. Gets bound to an ephemeral port on the first send.
+    static DatagramSocket create(int family = AF_INET);
+
+    // Port 0 picks an ephemeral one
+    static DatagramSocket bind(uint16_t port, int family = AF_INET);
+
+    Socket socket() const noexcept {
+        return socket_.borrow();
+    }
+
+    constexpr operator bool() const noexcept {
+        return (bool)socket_;
+    }
+
+    endpoint local_endpoint() const;
+
+    // Turns on segmentation and receive offloads where the system supports them.
+    // max_coalesced limits how much a single offloaded receive may hand over.
+    // Returns whether any of them is available.
+    bool enable_offloads(DWORD max_coalesced = 65535);
+
+    constexpr bool send_offload_enabled() const noexcept {
+        return send_offload;
+    }
+
+    constexpr bool recv_offload_enabled() const noexcept {
+        return recv_offload != 0;
+    }
+
+#pragma region IO
+    size_t send_to(std::span<const unsigned char> data, const endpoint &to);
+
+    received_datagram recv_from(std::span<unsigned char> data);
+
+    // Note: the buf must not be located in a coroutine stack.
+    AIO<size_t> send_to_async(std::span<const unsigned char> data, const endpoint &to);
+
+    // Note: the buf must not be located in a coroutine stack.
+    AIO<received_datagram> recv_from_async(std::span<unsigned char> data);
+#pragma endregion IO
+
+#pragma region Batch
+    // Sends all payloads as separate datagrams to the same destination, with as few calls as possible.
+    // UDP sends only block for as long as it takes to hand the data to the network stack, so there is
+    // no asynchronous version. Returns the number of datagrams sent.
+    size_t send_batch(std::span<const std::span<const unsigned char>> payloads, const endpoint &to);
+
+    // Waits for the first datagram, then takes whatever else is already queued without blocking.
+    // The buffer is split into slots of max_datagram bytes each, or of max_coalesced ones with
+    // receive offload enabled. Returns the number of entries filled in `out`.
+    size_t recv_batch(std::span<unsigned char> buffer, std::span<received_datagram> out, size_t max_datagram = 2048);
+
+    // Same as recv_batch, but waits for the first datagram asynchronously.
+    // Note: the buf must not be located in a coroutine stack.
+    AIO<size_t> recv_batch_async(std::span<unsigned char> buffer, std::span<received_datagram> out, size_t max_datagram = 2048);
+#pragma endregion Batch
+};
+
+}  // namespace abel
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/IOBase.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <Windows.h>
+#include <span>
+#include <string>
+#include <cstdint>
+#include <utility>
+
+namespace abel {
+
+// A heap buffer with a guaranteed alignment, as required by unbuffered IO
+class AlignedBuffer {
+protected:
+    unsigned char *data_ = nullptr;
+    size_t size_ = 0;
+
+public:
+    constexpr AlignedBuffer() noexcept = default;
+
+    // `alignment` must be a power of two
+    AlignedBuffer(size_t size, size_t alignment);
+
+    AlignedBuffer(const AlignedBuffer &) = delete;
+    AlignedBuffer &operator=(const AlignedBuffer &) = delete;
+
+    constexpr AlignedBuffer(AlignedBuffer &&other) noexcept :
+        data_{other.data_}, size_{other.size_} {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+
+    constexpr AlignedBuffer &operator=(AlignedBuffer &&other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+
+    ~AlignedBuffer() noexcept;
+
+    constexpr unsigned char *data() const noexcept {
+        return data_;
+    }
+
+    constexpr size_t size() const noexcept {
+        return size_;
+    }
+
+    constexpr std::span<unsigned char> span() const noexcept {
+        return {data_, size_};
+    }
+
+    constexpr operator std::span<unsigned char>() const noexcept {
+        return span();
+    }
+
+    constexpr operator std::span<const unsigned char>() const noexcept {
+        return span();
+    }
+};
+
+// A file opened for unbuffered IO (FILE_FLAG_NO_BUFFERING), bypassing the system file cache.
+// Every offset, buffer address and transfer size must be a multiple of alignment(); this is
+// validated on each call. Use allocate() to get suitable buffers. Since only whole sectors
+// can be written, call set_file_size() to trim the file once done.
+// The file is always opened for overlapped IO, so both the sync and the async interfaces are available.
+class DirectFile : public IOBase {
+protected:
+    OwningHandle file{};
+    size_t alignment_ = 0;
+    uint64_t position = 0;
+
+    void validate_request(uint64_t offset, const void *data, size_t size) const;
+
+public:
+    DirectFile() noexcept = default;
+
+    DirectFile(const DirectFile &) = delete;
+    DirectFile &operator=(const DirectFile &) = delete;
+    DirectFile(DirectFile &&) noexcept = default;
+    DirectFile &operator=(DirectFile &&) noexcept = default;
+
+    // `writeThrough` additionally makes writes bypass the disk's own write cache
+    static DirectFile open(
+        const std::string &path,
+        DWORD access = GENERIC_READ,
+        DWORD creationDisposition = OPEN_EXISTING,
+        bool writeThrough = false
+    );
+
+    Handle handle() const noexcept {
+        return file;
+    }
+
+    constexpr size_t alignment() const noexcept {
+        return alignment_;
+    }
+
+    // Allocates a suitably aligned buffer, rounding the size up to the alignment
+    AlignedBuffer allocate(size_t size) const;
+
+    uint64_t file_size() const {
+        return file.file_size();
+    }
+
+    void set_file_size(uint64_t size) {
+        file.set_file_size(size);
+    }
+
+    constexpr uint64_t tell() const noexcept {
+        return position;
+    }
+
+    // Must be aligned
+    void seek(uint64_t offset);
+
+#pragma region IO
+    eof<size_t> read_at(uint64_t offset, std::span<unsigned char> data);
+
+    eof<size_t> write_at(uint64_t offset, std::span<const unsigned char> data);
+
+    AIO<eof<size_t>> read_async_at(uint64_t offset, std::span<unsigned char> data);
+
+    AIO<eof<size_t>> write_async_at(uint64_t offset, std::span<const unsigned char> data);
+
+    // The streaming interface reads and writes at the current position and advances it
+
+    eof<size_t> read_into(std::span<unsigned char> data);
+
+    eof<size_t> write_from(std::span<const unsigned char> data);
+
+    AIO<eof<size_t>> read_async_into(std::span<unsigned char> data);
+
+    AIO<eof<size_t>> write_async_from(std::span<const unsigned char> data);
+#pragma endregion IO
+};
+
+}  // namespace abel
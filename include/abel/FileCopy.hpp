@@ -0,0 +1,42 @@
+#pragma once
+
+#include <abel/Handle.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <Windows.h>
+#include <string>
+#include <cstdint>
+#include <functional>
+
+namespace abel {
+
+struct copy_progress {
+    uint64_t copied_bytes = 0;
+    uint64_t total_bytes = 0;
+    aio_clock::duration elapsed{};
+
+    // In bytes per second
+    double throughput() const noexcept {
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        return seconds > 0 ? (double)copied_bytes / seconds : 0;
+    }
+};
+
+struct copy_options {
+    // Rounded up to a multiple of 64 KiB
+    size_t chunk_size = 1024 * 1024;
+    // The number of chunks being read or written at any time
+    size_t depth = 8;
+    bool preallocate = true;
+    // Invoked after every chunk written
+    std::function<void(const copy_progress &)> on_progress{};
+};
+
+// Copies the whole of `src` into `dst`, keeping `options.depth` chunk reads and writes in flight at once.
+// Both handles must have been opened with FILE_FLAG_OVERLAPPED. `dst` ends up exactly as long as `src`.
+AIO<copy_progress> copy_file_async(Handle src, Handle dst, copy_options options = {});
+
+// Opens the files and runs copy_file_async to completion on the calling thread
+copy_progress copy_file(const std::string &src, const std::string &dst, copy_options options = {});
+
+}  // namespace abel
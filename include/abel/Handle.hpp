@@ -12,6 +12,7 @@
 #include <concepts>
 #include <type_traits>
 #include <memory>
+#include <string>
 
 
 namespace abel {
@@ -21,6 +22,8 @@ class OwningHandle;
 template <typename T>
 class AIO;
 
+class PendingIO;
+
 class ConsoleAsyncIO;
 class ConsoleEventPeek;
 
@@ -32,6 +35,9 @@ class Handle : public IOBase {
 protected:
     HANDLE value;
 
+    // Drops the BlockingIOPool registration of a handle about to be closed
+    static void forget_synchronous(HANDLE value) noexcept;
+
 public:
     constexpr Handle() noexcept :
         value(NULL) {
@@ -82,7 +88,13 @@ public:
     // Writes the contents. Returns the number of bytes written and eof status. All bytes must be written after a successful invocation.
     eof<size_t> write_from(std::span<const unsigned char> data);
 
-    // Note: asynchronous IO (below) requires the handle to have been opened with FILE_FLAG_OVERLAPPED
+    // Tells whether the handle was opened without FILE_FLAG_OVERLAPPED, i.e. all IO on it blocks.
+    // Costs a system call, so check once and keep the answer rather than asking before every operation.
+    bool is_synchronous() const;
+
+    // Note: asynchronous IO (below) requires the handle to have been opened with FILE_FLAG_OVERLAPPED,
+    // or to be registered with BlockingIOPool, in which case the pool performs it instead.
+    // open_file, clone and Pipe::create take care of the latter for the synchronous handles they create.
 
     // Cancels all pending async operations on this handle
     void cancel_async();
@@ -92,8 +104,68 @@ public:
 
     // Same as write_from, but returns an awaitable. Note: the buf must not be located in a coroutine stack.
     AIO<eof<size_t>> write_async_from(std::span<const unsigned char> data);
+
+    // Positional IO (like pread/pwrite): only meaningful for seekable handles, i.e. files.
+    // The file pointer isn't used, but on synchronous handles it is left right after the transferred range,
+    // so don't mix these with read_into/write_from there. Reading at or past the end of file yields eof.
+
+    struct read_request {
+        uint64_t offset;
+        std::span<unsigned char> data;
+    };
+
+    struct write_request {
+        uint64_t offset;
+        std::span<const unsigned char> data;
+    };
+
+    // Works on both overlapped and synchronous handles
+    eof<size_t> read_at(uint64_t offset, std::span<unsigned char> data);
+
+    // Works on both overlapped and synchronous handles
+    eof<size_t> write_at(uint64_t offset, std::span<const unsigned char> data);
+
+    // Starts an overlapped read tracked by `op`. Collect the result with op.result() once op.event_done() is signaled.
+    // Returns false if the read hit the end of file right away, in which case nothing is pending.
+    bool begin_read_at(PendingIO &op, uint64_t offset, std::span<unsigned char> data);
+
+    // Starts an overlapped write tracked by `op`. Collect the result with op.result() once op.event_done() is signaled.
+    void begin_write_at(PendingIO &op, uint64_t offset, std::span<const unsigned char> data);
+
+    AIO<eof<size_t>> read_async_at(uint64_t offset, std::span<unsigned char> data);
+
+    AIO<eof<size_t>> write_async_at(uint64_t offset, std::span<const unsigned char> data);
+
+    // Issues all the reads at once, so they are all in flight together, then waits for all of them.
+    // Results are in the same order as the requests.
+    AIO<std::vector<eof<size_t>>> read_async_many_at(std::span<const read_request> requests);
+
+    // Issues all the writes at once, so they are all in flight together, then waits for all of them.
+    // Results are in the same order as the requests.
+    AIO<std::vector<eof<size_t>>> write_async_many_at(std::span<const write_request> requests);
 #pragma endregion IO
 
+#pragma region File
+    // See CreateFileA for the meaning of the parameters. Pass FILE_FLAG_OVERLAPPED in `flags` for proper async IO;
+    // without it, the handle is registered with BlockingIOPool so that async IO on it is offloaded.
+    static OwningHandle open_file(
+        const std::string &path,
+        DWORD access = GENERIC_READ,
+        DWORD creationDisposition = OPEN_EXISTING,
+        DWORD flags = FILE_ATTRIBUTE_NORMAL,
+        DWORD shareMode = FILE_SHARE_READ,
+        bool inheritHandle = false
+    );
+
+    uint64_t file_size() const;
+
+    // Sets the end of file, truncating or extending it
+    void set_file_size(uint64_t size);
+
+    // Reserves disk space for the file without changing its size. A hint to reduce fragmentation.
+    void preallocate(uint64_t size);
+#pragma endregion File
+
 #pragma region Synchronization
     static OwningHandle create_event(bool manualReset = false, bool initialState = false, bool inheritHandle = false);
 
@@ -220,6 +292,7 @@ public:
 
     ~OwningHandle() noexcept {
         if (value) {
+            forget_synchronous(value);
             CloseHandle(value);
             value = NULL;
         }
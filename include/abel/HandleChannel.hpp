@@ -0,0 +1,155 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/Socket.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <WinSock2.h>
+#include <Windows.h>
+#include <span>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+
+namespace abel {
+
+enum class handle_message_kind : uint32_t {
+    sockets = 1,
+    handles = 2,
+    load = 3,
+};
+
+// What a worker reports about itself to a ConnectionDispatcher
+struct load_report {
+    uint64_t active = 0;
+    // Total sockets received over the channel so far
+    uint64_t received = 0;
+};
+
+struct handle_message {
+    handle_message_kind kind{};
+    std::vector<OwningSocket> sockets{};
+    std::vector<OwningHandle> handles{};
+    load_report load{};
+};
+
+// Passes sockets and handles to the process on the other end of a local (AF_UNIX) socket.
+// Windows has no SCM_RIGHTS; instead, sockets are duplicated for the peer process with
+// WSADuplicateSocket and the resulting protocol info is sent over, while handles are duplicated
+// directly into the peer with DuplicateHandle, and only their values are sent.
+// Note: handles sent this way already exist in the peer, so if it never receives the message, they leak there.
+class HandleChannel {
+protected:
+    struct header {
+        handle_message_kind kind;
+        uint32_t count;
+    };
+
+    Socket channel;
+    DWORD peer_pid_ = 0;
+    // Only opened once handles are sent, since it takes PROCESS_DUP_HANDLE access to the peer
+    OwningHandle peer_process{};
+    uint64_t received_sockets = 0;
+
+    std::vector<unsigned char> encode_sockets(std::span<const Socket> sockets);
+    std::vector<unsigned char> encode_handles(std::span<const Handle> handles);
+    std::vector<unsigned char> encode_load(uint64_t active);
+
+    static size_t payload_size(const header &hdr);
+
+    handle_message decode(const header &hdr, std::span<const unsigned char> payload);
+
+public:
+    explicit HandleChannel(Socket channel);
+
+    constexpr DWORD peer_pid() const noexcept {
+        return peer_pid_;
+    }
+
+    // The originals stay open and usable in this process
+    void send_sockets(std::span<const Socket> sockets);
+    AIO<void> send_sockets_async(std::span<const Socket> sockets);
+
+    // The originals stay open and usable in this process
+    void send_handles(std::span<const Handle> handles);
+    AIO<void> send_handles_async(std::span<const Handle> handles);
+
+    void send_load(uint64_t active);
+    AIO<void> send_load_async(uint64_t active);
+
+    // Returns eof once the peer has closed the channel
+    eof<handle_message> recv();
+    AIO<eof<handle_message>> recv_async();
+};
+
+struct dispatcher_stats {
+    uint64_t dispatched = 0;
+    // Time spent duplicating and sending the sockets
+    aio_clock::duration total_handoff{};
+    aio_clock::duration max_handoff{};
+
+    aio_clock::duration average_handoff() const noexcept {
+        return dispatched ? total_handoff / dispatched : aio_clock::duration{};
+    }
+};
+
+// Hands accepted connections over to worker processes, for a prefork-style server in which
+// a front process accepts and the workers serve. Each connection goes to the worker with the
+// least load, as reported by the workers themselves plus whatever is still in transit to them.
+// The load reports arrive through monitor(), so it has to run on the same thread as dispatch().
+class ConnectionDispatcher {
+protected:
+    struct worker {
+        HandleChannel channel;
+        load_report last_report{};
+        uint64_t dispatched = 0;
+        bool alive = true;
+
+        uint64_t estimated_load() const noexcept {
+            // Sockets sent, but not yet received by the worker
+            uint64_t in_transit = dispatched - std::min<uint64_t>(last_report.received, dispatched);
+            return last_report.active + in_transit;
+        }
+    };
+
+    std::vector<std::unique_ptr<worker>> workers{};
+    dispatcher_stats stats_{};
+
+    // The least loaded live worker
+    size_t pick();
+
+    void record_handoff(aio_clock::time_point start) noexcept;
+
+public:
+    ConnectionDispatcher() = default;
+
+    ConnectionDispatcher(const ConnectionDispatcher &other) = delete;
+    ConnectionDispatcher &operator=(const ConnectionDispatcher &other) = delete;
+
+    // Returns the worker index
+    size_t add_worker(Socket channel);
+
+    size_t worker_count() const noexcept {
+        return workers.size();
+    }
+
+    uint64_t estimated_load(size_t idx) const noexcept {
+        return workers[idx]->estimated_load();
+    }
+
+    // Sends the connection to the least loaded worker and closes it here. Returns the worker index
+    size_t dispatch(OwningSocket connection);
+    AIO<size_t> dispatch_async(OwningSocket connection);
+
+    // Processes the worker's load reports until it disconnects, after which it gets no more connections.
+    // Meant to run as a separate task per worker, alongside the accept loop.
+    AIO<void> monitor(size_t idx);
+
+    constexpr const dispatcher_stats &stats() const noexcept {
+        return stats_;
+    }
+};
+
+}  // namespace abel
@@ -17,6 +17,9 @@ class AIO;
 
 class IOBase;
 
+class BufferRing;
+class BufferLease;
+
 struct unit {};
 
 template <typename T>
@@ -60,6 +63,12 @@ concept async_writable = std::derived_from<T, IOBase> && requires(T t, std::span
 template <typename T>
 concept async_io = async_readable<T> && async_writable<T>;
 
+// Streams that can wait for data before committing a buffer to it
+template <typename T>
+concept pooled_readable = std::derived_from<T, IOBase> && requires(T t, BufferRing &ring) {
+    { t.read_async_pooled(ring) } -> std::same_as<AIO<eof<BufferLease>>>;
+};
+
 class IOBase {
 public:
     template <typename Self>
@@ -182,4 +191,22 @@ AIO<void> async_transfer(S src, D dst, size_t buf_size = 4096) {
     }
 }
 
+// Same as async_transfer, but only holds a buffer from the ring while there is data in flight,
+// so that many mostly idle transfers don't each keep one. The ring must outlive the transfer.
+template <pooled_readable S, async_writable D>
+AIO<void> async_transfer_pooled(S src, D dst, BufferRing &ring) {
+    while (true) {
+        auto read_result = co_await src.read_async_pooled(ring);
+        if (read_result.value.size() > 0) {
+            auto write_result = co_await dst.write_async_full_from(read_result.value.data());
+            if (write_result.is_eof) {
+                break;
+            }
+        }
+        if (read_result.is_eof) {
+            break;
+        }
+    }
+}
+
 }  // namespace abel
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/IOBase.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <Windows.h>
+#include <span>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <optional>
+
+namespace abel {
+
+struct io_pool_stats {
+    // Submitted, but not picked up by a worker yet
+    size_t queued = 0;
+    size_t running = 0;
+    uint64_t completed = 0;
+    // From submission to completion
+    aio_clock::duration total_latency{};
+    aio_clock::duration max_latency{};
+
+    aio_clock::duration average_latency() const noexcept {
+        return completed ? total_latency / completed : aio_clock::duration{};
+    }
+};
+
+// A bounded pool of worker threads that perform blocking IO on behalf of AIOs.
+// Handles opened without FILE_FLAG_OVERLAPPED cannot do asynchronous IO: calling ReadFile on them
+// blocks, which would stall every other task in the same ParallelAIOs. Handle::open_file, Pipe::create
+// and Handle::clone register the synchronous handles they create, and Handle's async IO on a registered
+// handle goes through instance() instead; the completion is signaled back to the owning loop through an event.
+// Handles that come from elsewhere can be registered by hand, or wrapped in OffloadedHandle.
+class BlockingIOPool {
+protected:
+    struct job;
+
+    PTP_POOL pool = nullptr;
+    PTP_CLEANUP_GROUP cleanup = nullptr;
+    TP_CALLBACK_ENVIRON environ_{};
+
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> running{0};
+    std::atomic<uint64_t> completed{0};
+    std::atomic<int64_t> total_latency_ns{0};
+    std::atomic<int64_t> max_latency_ns{0};
+
+    static void CALLBACK run_job(PTP_CALLBACK_INSTANCE instance, void *context);
+
+    AIO<eof<size_t>> submit(std::shared_ptr<job> task);
+
+public:
+    explicit BlockingIOPool(size_t max_threads = 4);
+
+    BlockingIOPool(const BlockingIOPool &) = delete;
+    BlockingIOPool &operator=(const BlockingIOPool &) = delete;
+
+    // Waits for the running jobs and cancels the queued ones
+    ~BlockingIOPool() noexcept;
+
+    // The default pool of OffloadedHandle. It is never destroyed, so that exiting the process
+    // is not held up by workers blocked on IO that will never complete.
+    static BlockingIOPool &instance();
+
+    // Note: the buffer must stay alive until completion, even if the AIO gets destroyed earlier
+    AIO<eof<size_t>> read_async(Handle handle, std::span<unsigned char> data);
+
+    // Note: the buffer must stay alive until completion, even if the AIO gets destroyed earlier
+    AIO<eof<size_t>> write_async(Handle handle, std::span<const unsigned char> data);
+
+    // Note: the buffer must stay alive until completion, even if the AIO gets destroyed earlier
+    AIO<eof<size_t>> read_async_at(Handle handle, uint64_t offset, std::span<unsigned char> data);
+
+    // Note: the buffer must stay alive until completion, even if the AIO gets destroyed earlier
+    AIO<eof<size_t>> write_async_at(Handle handle, uint64_t offset, std::span<const unsigned char> data);
+
+    io_pool_stats stats() const noexcept;
+
+    // Marks the handle as synchronous, so that Handle's async IO on it gets offloaded. Checking costs
+    // no system call, unlike Handle::is_synchronous(). The mark goes away when the handle is closed
+    // through Handle::close() or OwningHandle; a handle closed any other way must be unregistered first.
+    static void register_synchronous(Handle handle);
+
+    static void unregister(Handle handle) noexcept;
+
+    static bool is_registered(Handle handle) noexcept;
+};
+
+// A handle opened without FILE_FLAG_OVERLAPPED, whose async IO is performed by a BlockingIOPool.
+// Only needed for handles that aren't registered with BlockingIOPool, or to use a pool other than the default one.
+class OffloadedHandle : public IOBase {
+protected:
+    Handle handle;
+    BlockingIOPool *pool;
+
+public:
+    explicit OffloadedHandle(Handle handle, BlockingIOPool *pool = &BlockingIOPool::instance()) :
+        handle{handle}, pool{pool} {
+    }
+
+    template <typename Self>
+    constexpr auto &inner(this Self &self) {
+        return self.handle;
+    }
+
+#pragma region IO
+    eof<size_t> read_into(std::span<unsigned char> data) {
+        return handle.read_into(data);
+    }
+
+    eof<size_t> write_from(std::span<const unsigned char> data) {
+        return handle.write_from(data);
+    }
+
+    // Note: the buffer must stay alive until completion, even if the AIO gets destroyed earlier
+    AIO<eof<size_t>> read_async_into(std::span<unsigned char> data) {
+        return pool->read_async(handle, data);
+    }
+
+    // Note: the buffer must stay alive until completion, even if the AIO gets destroyed earlier
+    AIO<eof<size_t>> write_async_from(std::span<const unsigned char> data) {
+        return pool->write_async(handle, data);
+    }
+#pragma endregion IO
+};
+
+}  // namespace abel
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/IOBase.hpp>
+
+#include <Windows.h>
+#include <span>
+#include <string>
+#include <cstdint>
+#include <utility>
+
+namespace abel {
+
+// Expected access pattern, used to drive prefetching of mapped windows
+enum class access_hint {
+    normal,
+    // Prefetch each window as soon as it gets mapped
+    sequential,
+    // Never prefetch; pages are faulted in on demand
+    random,
+};
+
+// A read-only memory-mapped view of a file that exposes its contents as spans without copying.
+// At most `window_size` bytes are mapped at a time; accessing data outside the current window
+// slides it, which invalidates previously returned spans. This keeps the address space usage
+// bounded for files of any size.
+// Also implements sync_readable, so IOBase helpers can consume it sequentially.
+class MappedFile : public IOBase {
+protected:
+    OwningHandle mapping{};
+    uint64_t size_ = 0;
+    size_t window_size = 0;
+    access_hint hint = access_hint::normal;
+
+    const unsigned char *view_ = nullptr;
+    uint64_t view_offset = 0;
+    size_t view_size = 0;
+
+    uint64_t position = 0;
+
+    void unmap() noexcept;
+
+    // Ensures [offset, offset + length) lies within the current window
+    void map(uint64_t offset, size_t length);
+
+public:
+    static constexpr size_t default_window_size = 64 * 1024 * 1024;
+
+    MappedFile() noexcept = default;
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    ~MappedFile() noexcept;
+
+    // The file handle may be closed afterwards: the mapping keeps a reference to the file.
+    // `window_size` is rounded up to the allocation granularity.
+    static MappedFile open(Handle file, size_t window_size = default_window_size, access_hint hint = access_hint::normal);
+
+    static MappedFile open(const std::string &path, size_t window_size = default_window_size, access_hint hint = access_hint::normal);
+
+    constexpr uint64_t size() const noexcept {
+        return size_;
+    }
+
+    void advise(access_hint hint_) noexcept {
+        hint = hint_;
+    }
+
+    // Returns the bytes at [offset, offset + length), clamped to the end of the file.
+    // Windows start at multiples of the allocation granularity, so `offset % granularity + length`
+    // must not exceed the window size. The span is valid until the window slides.
+    std::span<const unsigned char> view(uint64_t offset, size_t length);
+
+    // Returns up to `max_length` bytes at the current position without copying, and advances past them.
+    // The result is shorter than requested at window boundaries and at the end of the file.
+    std::span<const unsigned char> next(size_t max_length = (size_t)-1);
+
+    constexpr uint64_t tell() const noexcept {
+        return position;
+    }
+
+    void seek(uint64_t offset);
+
+#pragma region IO
+    // Copies data from the current position. Prefer next() to avoid the copy.
+    eof<size_t> read_into(std::span<unsigned char> data);
+#pragma endregion IO
+};
+
+}  // namespace abel
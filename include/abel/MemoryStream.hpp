@@ -0,0 +1,174 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/IOBase.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <Windows.h>
+#include <span>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+namespace abel {
+
+// A bounded single-direction in-memory byte queue, shared by the two ends of a MemoryStream pair.
+// Thread-safe. Kernel events are only touched when a side actually has to wait.
+class MemoryQueue {
+protected:
+    mutable std::mutex mutex{};
+    std::vector<unsigned char> storage;
+    size_t head = 0;
+    size_t used = 0;
+    bool write_closed = false;
+    bool read_closed = false;
+    // Signaled while there is data to read, or the writer is gone
+    OwningHandle readable_ = Handle::create_event(true, false);
+    // Signaled while there is free space, or the reader is gone
+    OwningHandle writable_ = Handle::create_event(true, true);
+
+    void update_events();
+
+public:
+    explicit MemoryQueue(size_t capacity);
+
+    MemoryQueue(const MemoryQueue &) = delete;
+    MemoryQueue &operator=(const MemoryQueue &) = delete;
+
+    // Non-blocking. Returns eof once the queue is drained and the writer has closed it.
+    // A zero value without eof means there was nothing to read.
+    eof<size_t> try_read(std::span<unsigned char> data);
+
+    // Non-blocking. Returns eof if the reader has closed the queue.
+    // A zero value without eof means there was no free space.
+    eof<size_t> try_write(std::span<const unsigned char> data);
+
+    void close_write();
+
+    void close_read();
+
+    size_t size() const;
+
+    size_t capacity() const noexcept {
+        return storage.size();
+    }
+
+    Handle readable() const noexcept {
+        return readable_;
+    }
+
+    Handle writable() const noexcept {
+        return writable_;
+    }
+};
+
+// One end of an in-memory duplex loopback stream. Implements both sync and async IO,
+// so IOBase helpers can be exercised and measured without any kernel IO objects.
+// Copies refer to the same end.
+class MemoryStream : public IOBase {
+protected:
+    std::shared_ptr<MemoryQueue> rx{};
+    std::shared_ptr<MemoryQueue> tx{};
+
+public:
+    MemoryStream() = default;
+
+    MemoryStream(std::shared_ptr<MemoryQueue> rx, std::shared_ptr<MemoryQueue> tx) :
+        rx{std::move(rx)}, tx{std::move(tx)} {
+    }
+
+    MemoryStream(const MemoryStream &) = default;
+    MemoryStream &operator=(const MemoryStream &) = default;
+    MemoryStream(MemoryStream &&) = default;
+    MemoryStream &operator=(MemoryStream &&) = default;
+
+    static std::pair<MemoryStream, MemoryStream> create_pair(size_t capacity = 64 * 1024);
+
+#pragma region IO
+    // Blocks until some data is available
+    eof<size_t> read_into(std::span<unsigned char> data);
+
+    // Blocks until some space is available. Unlike Handle, may write only a part of the buffer.
+    eof<size_t> write_from(std::span<const unsigned char> data);
+
+    AIO<eof<size_t>> read_async_into(std::span<unsigned char> data);
+
+    AIO<eof<size_t>> write_async_from(std::span<const unsigned char> data);
+#pragma endregion IO
+
+    // Signals eof to the peer once it has read everything written so far
+    void shutdown_write();
+
+    // Makes further writes by the peer fail with eof
+    void shutdown_read();
+};
+
+// Wraps a stream and deterministically splits every operation into short reads and partial writes
+// of pseudo-random sizes in [1, max_*]. Helps to verify that code handles them correctly.
+// A max of 0 leaves that direction untouched.
+template <typename T>
+class FaultInjecting : public IOBase {
+protected:
+    T stream;
+    size_t max_read = 0;
+    size_t max_write = 0;
+    uint64_t rng_state;
+
+    size_t limit(size_t wanted, size_t max_chunk) noexcept {
+        if (max_chunk == 0 || wanted == 0) {
+            return wanted;
+        }
+
+        // xorshift64
+        rng_state ^= rng_state << 13;
+        rng_state ^= rng_state >> 7;
+        rng_state ^= rng_state << 17;
+
+        return std::min<size_t>(wanted, 1 + rng_state % max_chunk);
+    }
+
+public:
+    FaultInjecting(T stream, size_t max_read, size_t max_write, uint64_t seed = 0x9E3779B97F4A7C15) :
+        stream{std::move(stream)}, max_read{max_read}, max_write{max_write}, rng_state{seed ? seed : 1} {
+    }
+
+    FaultInjecting(const FaultInjecting &) = default;
+    FaultInjecting &operator=(const FaultInjecting &) = default;
+    FaultInjecting(FaultInjecting &&) = default;
+    FaultInjecting &operator=(FaultInjecting &&) = default;
+
+    template <typename Self>
+    constexpr auto &inner(this Self &self) {
+        return self.stream;
+    }
+
+    eof<size_t> read_into(std::span<unsigned char> data)
+        requires sync_readable<T>
+    {
+        return stream.read_into(data.first(limit(data.size(), max_read)));
+    }
+
+    eof<size_t> write_from(std::span<const unsigned char> data)
+        requires sync_writable<T>
+    {
+        return stream.write_from(data.first(limit(data.size(), max_write)));
+    }
+
+    AIO<eof<size_t>> read_async_into(std::span<unsigned char> data)
+        requires async_readable<T>
+    {
+        co_return co_await stream.read_async_into(data.first(limit(data.size(), max_read)));
+    }
+
+    AIO<eof<size_t>> write_async_from(std::span<const unsigned char> data)
+        requires async_writable<T>
+    {
+        co_return co_await stream.write_async_from(data.first(limit(data.size(), max_write)));
+    }
+};
+
+}  // namespace abel
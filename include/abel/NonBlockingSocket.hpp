@@ -0,0 +1,96 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/Socket.hpp>
+#include <abel/IOBase.hpp>
+#include <abel/Concurrency.hpp>
+#include <abel/BufferRing.hpp>
+
+#include <WinSock2.h>
+#include <Windows.h>
+#include <span>
+#include <string>
+#include <cstdint>
+#include <optional>
+
+namespace abel {
+
+// A socket driven by readiness rather than completion. Overlapped IO hands a buffer to the kernel
+// upfront and keeps it pinned until the operation completes, which for many mostly idle connections
+// means a lot of memory doing nothing. Here the socket is put into non-blocking mode and associated
+// with an event through WSAEventSelect instead; operations are attempted right away, and only
+// when they would block does the task wait for the corresponding network event.
+// Since the in-progress operations keep pointers to this object, it must not be moved while any are running.
+class NonBlockingSocket : public IOBase {
+protected:
+    OwningSocket socket_{};
+    OwningHandle event{};
+    // Network events reported and not consumed yet
+    long ready = 0;
+    int errors[FD_MAX_EVENTS]{};
+
+    // Collects the network events reported since the last call, and resets the event
+    void poll_events();
+
+    void wait_sync(long mask);
+
+    AIO<void> wait_async(long mask);
+
+    // These return nullopt if the operation would block
+    std::optional<eof<size_t>> try_read(std::span<unsigned char> data);
+    std::optional<eof<size_t>> try_write(std::span<const unsigned char> data);
+    std::optional<OwningSocket> try_accept();
+
+public:
+    NonBlockingSocket() = default;
+
+    // Takes over the socket and switches it into non-blocking mode
+    explicit NonBlockingSocket(OwningSocket socket);
+
+    NonBlockingSocket(const NonBlockingSocket &) = delete;
+    NonBlockingSocket &operator=(const NonBlockingSocket &) = delete;
+    NonBlockingSocket(NonBlockingSocket &&) = default;
+    NonBlockingSocket &operator=(NonBlockingSocket &&) = default;
+
+    static NonBlockingSocket listen(uint16_t port);
+
+    // Tries every address the host resolves to in turn. Note: the name resolution itself is blocking
+    static AIO<NonBlockingSocket> connect_async(std::string host, uint16_t port);
+
+    constexpr Socket socket() const noexcept {
+        return socket_.borrow();
+    }
+
+    constexpr operator bool() const noexcept {
+        return (bool)socket_;
+    }
+
+    NonBlockingSocket accept();
+
+    AIO<NonBlockingSocket> accept_async();
+
+    // Completes once there is data (or eof) to be read without blocking
+    AIO<void> wait_readable();
+
+    // Completes once there is send buffer space to write without blocking
+    AIO<void> wait_writable();
+
+#pragma region IO
+    eof<size_t> read_into(std::span<unsigned char> data);
+
+    eof<size_t> write_from(std::span<const unsigned char> data);
+
+    // Unlike with Socket, the buffer is only touched while the task is running, so it may live anywhere
+    AIO<eof<size_t>> read_async_into(std::span<unsigned char> data);
+
+    AIO<eof<size_t>> write_async_from(std::span<const unsigned char> data);
+
+    // Waits until there is data, and only then borrows a buffer from the ring to read it into
+    AIO<eof<BufferLease>> read_async_pooled(BufferRing &ring);
+#pragma endregion IO
+
+    void shutdown(int how = SD_BOTH);
+};
+
+}  // namespace abel
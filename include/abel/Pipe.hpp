@@ -7,6 +7,18 @@
 
 namespace abel {
 
+struct pipe_options {
+    // Requested buffer size, zero for the system default. The system treats it as a quota
+    // rather than a hard size, and it can't be changed once the pipe exists
+    DWORD capacity = 0;
+    // Ends handed to a child process are usually meant to be inherited and used synchronously,
+    // while the one kept is better off overlapped and private
+    bool inherit_read = true;
+    bool inherit_write = true;
+    bool overlapped_read = true;
+    bool overlapped_write = true;
+};
+
 class Pipe {
 public:
     OwningHandle read{};
@@ -22,6 +34,11 @@ public:
 
     // Actually creates a named pipe secretly, because unnamed pipes, as it turns out, do not support overlapped IO.
     static Pipe create_async(bool inheritHandles = true, DWORD bufSize = 0);
+
+    static Pipe create_async(const pipe_options &options);
+
+    // The buffer size the system actually assigned to the read side
+    DWORD capacity() const;
 };
 
 }  // namespace abel
@@ -40,6 +40,9 @@ public:
     static OwningHandle open(DWORD pid, DWORD access = PROCESS_ALL_ACCESS, bool inheritHandles = false);
 
     static OwningHandle find(std::string_view name);
+
+    // The resident memory of the process, in bytes
+    static size_t working_set(Handle process = GetCurrentProcess());
 };
 
 }  // namespace abel
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <abel/IOBase.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <span>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+namespace abel {
+
+// A token bucket measured in bytes. Tokens refill at `rate` bytes per second, up to `burst`.
+// Refilling happens lazily from aio_clock whenever the bucket is inspected, so idle buckets cost nothing.
+// A single bucket may be shared by several streams to limit them as a group.
+class TokenBucket {
+protected:
+    double rate;
+    double burst;
+    double tokens;
+    aio_clock::time_point last_refill;
+
+public:
+    TokenBucket(double rate, double burst);
+
+    void refill(aio_clock::time_point now = aio_clock::now()) noexcept;
+
+    // The number of whole tokens currently available
+    size_t available(aio_clock::time_point now = aio_clock::now()) noexcept;
+
+    void consume(size_t amount) noexcept;
+
+    // The earliest moment `amount` tokens will be available (amounts above `burst` are clamped to it)
+    aio_clock::time_point ready_at(size_t amount, aio_clock::time_point now = aio_clock::now()) noexcept;
+
+    void set_rate(double rate, double burst);
+
+    constexpr double get_rate() const noexcept {
+        return rate;
+    }
+
+    constexpr double get_burst() const noexcept {
+        return burst;
+    }
+};
+
+// Wraps a stream and limits its throughput by one or two token buckets: typically one of its own
+// and one shared by a group of streams. Either may be null. Async operations suspend the AIO via
+// sleep_until when out of tokens; sync operations block the thread instead.
+// Non-owning, like Checksummed: the buckets must outlive it.
+template <typename T>
+class RateLimited : public IOBase {
+protected:
+    T stream;
+    TokenBucket *own = nullptr;
+    TokenBucket *group = nullptr;
+    // Do not wake up for less than this many bytes, unless the caller asked for less
+    size_t granularity = 4096;
+
+    size_t grant(size_t wanted, aio_clock::time_point now) {
+        size_t result = wanted;
+        if (own) {
+            result = std::min<size_t>(result, own->available(now));
+        }
+        if (group) {
+            result = std::min<size_t>(result, group->available(now));
+        }
+        return result;
+    }
+
+    aio_clock::time_point ready_at(size_t wanted, aio_clock::time_point now) {
+        aio_clock::time_point result = now;
+        if (own) {
+            result = std::max<aio_clock::time_point>(result, own->ready_at(wanted, now));
+        }
+        if (group) {
+            result = std::max<aio_clock::time_point>(result, group->ready_at(wanted, now));
+        }
+        return result;
+    }
+
+    void consume(size_t amount) {
+        if (own) {
+            own->consume(amount);
+        }
+        if (group) {
+            group->consume(amount);
+        }
+    }
+
+    // How many tokens are worth waking up for. Never more than a bucket can hold, or we would wait forever
+    size_t threshold(size_t wanted) const noexcept {
+        size_t result = std::min<size_t>(wanted, granularity);
+        if (own) {
+            result = std::min<size_t>(result, (size_t)own->get_burst());
+        }
+        if (group) {
+            result = std::min<size_t>(result, (size_t)group->get_burst());
+        }
+        return result;
+    }
+
+    size_t acquire_sync(size_t wanted) {
+        while (true) {
+            auto now = aio_clock::now();
+            size_t result = grant(wanted, now);
+            size_t needed = threshold(wanted);
+            if (result >= needed) {
+                return result;
+            }
+            auto delay = std::chrono::ceil<std::chrono::milliseconds>(ready_at(needed, now) - now);
+            Sleep((DWORD)std::max<long long>(delay.count(), 1));
+        }
+    }
+
+    AIO<size_t> acquire_async(size_t wanted) {
+        while (true) {
+            auto now = aio_clock::now();
+            size_t result = grant(wanted, now);
+            size_t needed = threshold(wanted);
+            if (result >= needed) {
+                co_return result;
+            }
+            co_await sleep_until{ready_at(needed, now)};
+        }
+    }
+
+public:
+    RateLimited(T stream, TokenBucket *own, TokenBucket *group = nullptr, size_t granularity = 4096) :
+        stream{std::move(stream)}, own{own}, group{group}, granularity{std::max<size_t>(granularity, 1)} {
+    }
+
+    RateLimited(const RateLimited &) = default;
+    RateLimited &operator=(const RateLimited &) = default;
+    RateLimited(RateLimited &&) = default;
+    RateLimited &operator=(RateLimited &&) = default;
+
+    template <typename Self>
+    constexpr auto &inner(this Self &self) {
+        return self.stream;
+    }
+
+    eof<size_t> read_into(std::span<unsigned char> data)
+        requires sync_readable<T>
+    {
+        size_t allowed = acquire_sync(data.size());
+        eof<size_t> result = stream.read_into(data.first(allowed));
+        consume(result.value);
+        return result;
+    }
+
+    // Note: unlike the underlying stream, this may write only a part of the buffer
+    eof<size_t> write_from(std::span<const unsigned char> data)
+        requires sync_writable<T>
+    {
+        size_t allowed = acquire_sync(data.size());
+        eof<size_t> result = stream.write_from(data.first(allowed));
+        consume(result.value);
+        return result;
+    }
+
+    AIO<eof<size_t>> read_async_into(std::span<unsigned char> data)
+        requires async_readable<T>
+    {
+        size_t allowed = co_await acquire_async(data.size());
+        eof<size_t> result = co_await stream.read_async_into(data.first(allowed));
+        consume(result.value);
+        co_return result;
+    }
+
+    AIO<eof<size_t>> write_async_from(std::span<const unsigned char> data)
+        requires async_writable<T>
+    {
+        size_t allowed = co_await acquire_async(data.size());
+        eof<size_t> result = co_await stream.write_async_from(data.first(allowed));
+        consume(result.value);
+        co_return result;
+    }
+};
+
+}  // namespace abel
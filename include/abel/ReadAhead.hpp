@@ -0,0 +1,114 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/IOBase.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <Windows.h>
+#include <span>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace abel {
+
+struct readahead_options {
+    // How many windows to keep in flight ahead of the reader
+    size_t depth = 4;
+    size_t min_window = 64 * 1024;
+    size_t max_window = 4 * 1024 * 1024;
+    // How many consecutive reads after a seek it takes to consider the access sequential again
+    size_t sequential_threshold = 2;
+};
+
+struct readahead_stats {
+    // Reads served from data that had already arrived
+    uint64_t hits = 0;
+    // Reads that had to wait for the disk
+    uint64_t misses = 0;
+    // Reads that bypassed the prefetcher, right after a seek
+    uint64_t direct_reads = 0;
+    uint64_t prefetched_bytes = 0;
+    size_t window_size = 0;
+};
+
+// A sequential reader over a file that keeps the next `depth` windows in flight asynchronously,
+// so that small reads are served from memory instead of paying a disk round trip each.
+// Window sizes adapt to the consumer: a read that has to wait doubles them, and a full round of
+// reads that did not halves them. Seeking drops the prefetched data, and prefetching resumes once
+// the access looks sequential again. Files that grow while being read (e.g. logs) are supported.
+// The file must have been opened with FILE_FLAG_OVERLAPPED.
+class ReadAhead : public IOBase {
+protected:
+    struct window {
+        // Must outlive op, whose destructor waits for the prefetch to stop writing into it
+        std::unique_ptr<unsigned char[]> buf{};
+        PendingIO op{};
+        size_t capacity = 0;
+        uint64_t offset = 0;
+        size_t length = 0;
+        size_t filled = 0;
+        size_t consumed = 0;
+        bool pending = false;
+    };
+
+    Handle file;
+    readahead_options options;
+    readahead_stats stats_{};
+
+    std::deque<std::unique_ptr<window>> windows{};
+    std::vector<std::unique_ptr<window>> spare{};
+
+    uint64_t position = 0;
+    uint64_t next_offset = 0;
+    uint64_t known_size = 0;
+    size_t sequential_run = 0;
+    size_t hit_streak = 0;
+
+    bool prefetching() const noexcept {
+        return sequential_run >= options.sequential_threshold;
+    }
+
+    // Issues reads until `depth` windows are in flight or the known end of file is reached
+    void refill();
+
+    void drop_windows() noexcept;
+
+    // Collects the front window's result, blocking if needed, and adapts the window size
+    // depending on whether the reader had to wait for it
+    void complete(window &front, bool was_ready);
+
+    // Copies out of the front window, and recycles it once drained
+    eof<size_t> consume(std::span<unsigned char> data);
+
+    // Makes sure there is a front window, unless at the end of file
+    bool ensure_front();
+
+public:
+    explicit ReadAhead(Handle file, readahead_options options = {}, uint64_t start = 0);
+
+    ReadAhead(const ReadAhead &) = delete;
+    ReadAhead &operator=(const ReadAhead &) = delete;
+    ReadAhead(ReadAhead &&) = default;
+    ReadAhead &operator=(ReadAhead &&) = default;
+
+    constexpr uint64_t tell() const noexcept {
+        return position;
+    }
+
+    void seek(uint64_t offset);
+
+    constexpr const readahead_stats &stats() const noexcept {
+        return stats_;
+    }
+
+#pragma region IO
+    eof<size_t> read_into(std::span<unsigned char> data);
+
+    AIO<eof<size_t>> read_async_into(std::span<unsigned char> data);
+#pragma endregion IO
+};
+
+}  // namespace abel
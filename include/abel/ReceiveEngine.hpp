@@ -0,0 +1,92 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/Socket.hpp>
+#include <abel/BufferRing.hpp>
+#include <abel/ShardedListener.hpp>
+#include <abel/ConnectionDrainer.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <WinSock2.h>
+#include <Windows.h>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <functional>
+
+namespace abel {
+
+struct receive_engine_options {
+    // Accepts kept posted at all times. This only bounds how many connections can be taken
+    // in a burst, not how many are served: each of those gets a task of its own
+    size_t accepts = 32;
+    size_t buffer_size = 16 * 1024;
+    // Shared by all connections; only the ones with data in flight hold one
+    size_t buffers = 16;
+};
+
+struct receive_engine_stats {
+    uint64_t accepted = 0;
+    uint64_t closed = 0;
+    uint64_t deliveries = 0;
+    uint64_t received_bytes = 0;
+};
+
+// Accepts connections and receives from them without dedicating a buffer to each one.
+// Accepts are kept posted and re-armed as soon as they complete, and every connection waits for
+// data with a zero-byte receive; a buffer is only borrowed from the shared ring once there is
+// something to put in it, and goes back as soon as the handler is done with it. Connections are
+// tasks of a TaskSet, so an idle one costs a coroutine frame, an event and a thread pool wait.
+// Runs on the calling thread.
+class ReceiveEngine {
+public:
+    // Receives each chunk of data as it arrives. Returns false to close the connection
+    using handler_t = std::function<AIO<bool>(Socket connection, BufferLease data)>;
+
+protected:
+    OwningSocket listener;
+    BufferRing ring;
+    std::vector<std::unique_ptr<PendingAccept>> accepts{};
+    handler_t handler;
+    ConnectionDrainer drainer{};
+    receive_engine_stats stats_{};
+    // Last, since the tasks refer to everything above
+    TaskSet tasks{};
+
+    AIO<void> accept_loop(PendingAccept &accept);
+
+    AIO<void> serve(OwningSocket connection);
+
+public:
+    ReceiveEngine(uint16_t port, handler_t handler, receive_engine_options options = {});
+
+    ReceiveEngine(const ReceiveEngine &other) = delete;
+    ReceiveEngine &operator=(const ReceiveEngine &other) = delete;
+
+    // Serves connections until the event is signaled, or forever if there is none.
+    // Then stops accepting and gives the open connections up to drain_timeout to finish
+    // the chunk being handled and close cleanly, after which the rest are reset
+    // (see ConnectionDrainer::drain for how long their handlers then get to return).
+    // The accepts stay stopped afterwards, so the engine can only run once.
+    void run(Handle stop = nullptr, aio_clock::duration drain_timeout = ConnectionDrainer::default_timeout);
+
+    constexpr const receive_engine_stats &stats() const noexcept {
+        return stats_;
+    }
+
+    // Only meaningful once run() has returned
+    const drain_stats &drain_results() const noexcept {
+        return drainer.stats();
+    }
+
+    buffer_ring_stats ring_stats() const noexcept {
+        return ring.stats();
+    }
+
+    Socket socket() const noexcept {
+        return listener.borrow();
+    }
+};
+
+}  // namespace abel
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/Socket.hpp>
+#include <abel/Thread.hpp>
+#include <abel/Concurrency.hpp>
+#include <abel/ConnectionDrainer.hpp>
+
+#include <WinSock2.h>
+#include <Windows.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <functional>
+
+namespace abel {
+
+// An AcceptEx kept posted on a listening socket. accept_async() waits for it to complete, hands out
+// the connection and immediately posts the next one, so that the kernel always has a socket to accept into.
+// Must stay in place while an accept is posted, so it is non-movable.
+class PendingAccept {
+protected:
+    // Address buffers for AcceptEx have to be 16 bytes larger than the largest address
+    static constexpr DWORD address_size = sizeof(sockaddr_storage) + 16;
+
+    Socket listener;
+    int family;
+    OwningSocket candidate{};
+    PendingIO op{};
+    bool stopped = false;
+    OVERLAPPED *overlapped = nullptr;
+    unsigned char addresses[2 * address_size]{};
+
+    void post();
+
+public:
+    explicit PendingAccept(Socket listener, int family = AF_INET);
+
+    PendingAccept(const PendingAccept &other) = delete;
+    PendingAccept &operator=(const PendingAccept &other) = delete;
+    PendingAccept(PendingAccept &&other) = delete;
+    PendingAccept &operator=(PendingAccept &&other) = delete;
+
+    // Connections reset by the peer before being accepted are skipped.
+    // Once stopped, returns an empty socket instead of waiting.
+    AIO<OwningSocket> accept_async();
+
+    // Cancels the posted accept and doesn't post any more, e.g. to stop taking connections while draining
+    void stop() noexcept;
+
+    constexpr bool is_stopped() const noexcept {
+        return stopped;
+    }
+};
+
+struct sharded_listener_options {
+    // Zero means one per processor
+    size_t shards = 0;
+    // How many accepts each shard keeps posted. This only bounds how many connections a shard
+    // can take in a burst; once accepted, each connection is served by a task of its own.
+    size_t accepts_per_shard = 16;
+};
+
+// A listener that spreads connection setup over several worker threads. There is no SO_REUSEPORT
+// balancing on Windows, so the shards share one listening socket instead, each keeping its own batch
+// of accepts posted on it; the kernel completes whichever is waiting, so no single thread has to keep
+// up with the whole accept rate. Connections are served on the thread of the shard that accepted them,
+// each as a task of the shard's TaskSet, so accepting goes on while handlers run.
+class ShardedListener {
+public:
+    // The ticket registers the connection for draining: draining() tells when to wrap up, set_idle()
+    // lets the drain half-close a connection that is only waiting for the next request, and finish()
+    // half-closes it once the last response is out. A connection still registered at the drain deadline
+    // gets reset, so the ticket must go before the socket does: a handler that closes the connection
+    // early or hands it off elsewhere drops it first (ticket = DrainTicket{}).
+    using handler_t = std::function<AIO<void>(OwningSocket connection, DrainTicket ticket)>;
+
+protected:
+    struct shard {
+        ShardedListener *owner = nullptr;
+        size_t index = 0;
+        size_t accept_count = 0;
+        std::atomic<uint64_t> accepted{0};
+        // Written by the shard's thread, only to be read once it has been joined
+        drain_stats drained{};
+        std::optional<Thread> thread{};
+
+        void run();
+
+        AIO<void> accept_loop(PendingAccept &accept, ConnectionDrainer &drainer, TaskSet &tasks);
+
+        AIO<void> serve(OwningSocket connection, ConnectionDrainer &drainer);
+    };
+
+    OwningSocket listener{};
+    OwningHandle stop_event = Handle::create_event(true, false);
+    std::atomic<bool> draining_{false};
+    // Set before stop_event is signaled
+    aio_clock::time_point drain_deadline{};
+    std::vector<std::unique_ptr<shard>> shards{};
+    handler_t handler{};
+    drain_stats drain_results_{};
+
+public:
+    explicit ShardedListener(uint16_t port, sharded_listener_options options = {});
+
+    ShardedListener(const ShardedListener &other) = delete;
+    ShardedListener &operator=(const ShardedListener &other) = delete;
+
+    // Stops the workers, draining the connections with the default timeout
+    ~ShardedListener() noexcept;
+
+    // Starts the workers. The handler is invoked on the accepting shard's thread for every connection.
+    void start(handler_t handler);
+
+    // Stops accepting, gives the handlers up to drain_timeout to return, resets the connections
+    // of the ones that haven't, and joins the workers. Handlers that still haven't returned
+    // ConnectionDrainer::unwind_timeout after that are destroyed. Keeps the listening socket open.
+    // The listener has no say in when a handler returns, so handlers that keep connections open
+    // between requests should use their tickets to wrap up instead of waiting for the next one.
+    void stop(aio_clock::duration drain_timeout = ConnectionDrainer::default_timeout) noexcept;
+
+    bool draining() const noexcept {
+        return draining_.load();
+    }
+
+    // Combined over all shards, from the last stop
+    constexpr const drain_stats &drain_results() const noexcept {
+        return drain_results_;
+    }
+
+    size_t shard_count() const noexcept {
+        return shards.size();
+    }
+
+    uint64_t accepted(size_t shard) const noexcept {
+        return shards[shard]->accepted.load();
+    }
+
+    Socket socket() const noexcept {
+        return listener.borrow();
+    }
+};
+
+}  // namespace abel
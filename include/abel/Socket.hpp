@@ -3,10 +3,12 @@
 #include <abel/Error.hpp>
 #include <abel/Handle.hpp>
 #include <abel/IOBase.hpp>
+#include <abel/Concurrency.hpp>
 
 #include <WinSock2.h>
 #include <Windows.h>
 #include <string>
+#include <chrono>
 #include <cstdint>
 #include <utility>
 
@@ -17,12 +19,15 @@
 namespace abel {
 
 class OwningSocket;
+class BufferRing;
+class BufferLease;
 
 class Socket : public IOBase {
 protected:
     SOCKET socket{INVALID_SOCKET};
 
-    static OwningSocket create();
+    uint64_t send_file_fallback(Handle file, uint64_t offset, uint64_t length);
+    AIO<uint64_t> send_file_fallback_async(Handle file, uint64_t offset, uint64_t length);
 
 public:
     constexpr Socket() noexcept :
@@ -38,11 +43,33 @@ public:
     constexpr Socket(Socket &&other) noexcept = default;
     constexpr Socket &operator=(Socket &&other) noexcept = default;
 
+    // Creates an overlapped-capable, non-inheritable socket
+    static OwningSocket create(int family = AF_INET, int type = SOCK_STREAM, int protocol = 0);
+
     static OwningSocket connect(std::string host, uint16_t port);
 
+    // Resolves the host and races connection attempts to its addresses, alternating between
+    // address families. A new attempt is started every `stagger` until one succeeds; the first
+    // one to connect wins and the rest are cancelled. Fails once the deadline has passed.
+    // Note: the name resolution itself is blocking
+    static AIO<OwningSocket> connect_async(
+        std::string host,
+        uint16_t port,
+        aio_clock::time_point deadline,
+        aio_clock::duration stagger = std::chrono::milliseconds(250)
+    );
+
     // TODO: Accept host?
     static OwningSocket listen(uint16_t port);
 
+    // Local (AF_UNIX) sockets, addressed by a filesystem path, skip the network stack entirely and
+    // work with the rest of the interface unchanged. Note: Windows only supports SOCK_STREAM ones.
+    // The socket file stays behind after the listener is closed; with remove_stale, such a leftover
+    // is deleted before binding, but only if it is a socket file that refuses connections.
+    static OwningSocket listen_local(const std::string &path, int type = SOCK_STREAM, bool remove_stale = true);
+
+    static OwningSocket connect_local(const std::string &path, int type = SOCK_STREAM);
+
     constexpr operator bool() const noexcept {
         return socket != INVALID_SOCKET;
     }
@@ -84,9 +111,33 @@ public:
 
     // Same as write_from, but returns an awaitable. Note: the buf must not be located in a coroutine stack.
     AIO<eof<size_t>> write_async_from(std::span<const unsigned char> data);
+
+    // Sends all the buffers with a single WSASend, as if they were one. Returns the total number of bytes written.
+    // Note: neither the buffers nor the span itself may be located in a coroutine stack.
+    AIO<eof<size_t>> write_async_gather(std::span<const std::span<const unsigned char>> buffers);
+
+    // Completes once there is data (or eof) to read, without committing a buffer to the read upfront.
+    // This is done with a zero-byte overlapped receive, so an idle connection holds no buffer at all.
+    AIO<void> wait_readable_async();
+
+    // Waits until there is data, and only then borrows a buffer from the ring to read it into.
+    // The lease holds the data read. Note: assumes this is the only reader of the socket
+    AIO<eof<BufferLease>> read_async_pooled(BufferRing &ring);
+
+    // Sends a range of the file with TransmitFile, so that the data goes from the file cache to the
+    // network without being copied through user space. Falls back to reading and writing in chunks
+    // if the source is not a disk file (in which case the offset is ignored), or the socket doesn't
+    // support it. Returns the number of bytes sent, which is less than `length` if the file ends first.
+    uint64_t send_file(Handle file, uint64_t offset, uint64_t length);
+
+    // Same as send_file, but returns an awaitable
+    AIO<uint64_t> send_file_async(Handle file, uint64_t offset, uint64_t length);
 #pragma endregion IO
 
     void shutdown(int how = SD_BOTH);
+
+    // Note: WSAEventSelect forces non-blocking mode, and it cannot be turned off while that is active
+    void set_nonblocking(bool nonblocking = true);
 };
 
 class OwningSocket : public Socket {
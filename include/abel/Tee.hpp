@@ -0,0 +1,155 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/IOBase.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <Windows.h>
+#include <span>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <utility>
+
+namespace abel {
+
+// What to do with a sink that falls behind by more than its lag limit
+enum class lag_policy {
+    // Skip the data that does not fit, but keep the sink attached
+    drop,
+    // Detach the sink and discard everything queued for it
+    disconnect,
+};
+
+// Broadcasts everything written to it to several async sinks. Each write is copied once into
+// a refcounted buffer shared by all sinks, and every sink is drained by its own pump task,
+// so a slow sink never stalls the writer or the other sinks.
+// Copies refer to the same broadcast.
+class Tee : public IOBase {
+public:
+    struct sink_stats {
+        size_t queued_bytes = 0;
+        size_t written_bytes = 0;
+        size_t dropped_bytes = 0;
+        bool attached = false;
+    };
+
+protected:
+    using chunk_t = std::shared_ptr<const std::vector<unsigned char>>;
+
+    struct sink_state {
+        std::deque<chunk_t> queue{};
+        size_t max_lag;
+        lag_policy policy;
+        sink_stats stats{};
+        // Signaled while the pump has something to do
+        OwningHandle wakeup = Handle::create_event(true, false);
+
+        sink_state(size_t max_lag, lag_policy policy) :
+            max_lag{max_lag}, policy{policy} {
+            stats.attached = true;
+        }
+    };
+
+    struct state {
+        std::mutex mutex{};
+        std::vector<std::unique_ptr<sink_state>> sinks{};
+        bool closed = false;
+    };
+
+    std::shared_ptr<state> shared{};
+
+    explicit Tee(std::shared_ptr<state> shared) :
+        shared{std::move(shared)} {
+    }
+
+    sink_state &get_sink(size_t sink) const;
+
+    // Note: the pump helpers are static since a pump may outlive the Tee it was started from
+
+    // Returns the next chunk to write. If there is none, the pump should stop when `done`
+    // is set, and wait for `wakeup` otherwise.
+    static chunk_t next_chunk(state &shared, sink_state &sink, bool &done);
+
+    // Detaches the sink if `dst` has reached eof or failed, with only `written` bytes of the chunk delivered
+    static void chunk_done(state &shared, sink_state &sink, size_t written, bool dst_eof);
+
+    template <async_writable D>
+    static AIO<void> run_pump(std::shared_ptr<state> shared, sink_state &target, D dst) {
+        while (true) {
+            bool done = false;
+            chunk_t chunk = next_chunk(*shared, target, done);
+            if (done) {
+                break;
+            }
+
+            if (!chunk) {
+                co_await event_signaled{target.wakeup};
+                continue;
+            }
+
+            // Not write_async_full_from, which throws on eof instead of letting us detach the sink
+            std::span<const unsigned char> rest{*chunk};
+            bool dst_eof = false;
+            try {
+                while (!rest.empty()) {
+                    eof<size_t> result = co_await dst.write_async_from(rest);
+                    rest = rest.subspan(result.value);
+                    if (result.is_eof) {
+                        dst_eof = true;
+                        break;
+                    }
+                }
+            } catch (...) {
+                // A broken sink is as good as a closed one
+                dst_eof = true;
+            }
+
+            chunk_done(*shared, target, chunk->size() - rest.size(), dst_eof);
+        }
+    }
+
+public:
+    Tee() = default;
+
+    Tee(const Tee &) = default;
+    Tee &operator=(const Tee &) = default;
+    Tee(Tee &&) = default;
+    Tee &operator=(Tee &&) = default;
+
+    static Tee create();
+
+    // Registers a new sink that may lag behind by at most `max_lag` bytes. Returns its index.
+    // The sink only receives data written after this call, and only once its pump is running.
+    size_t add_sink(size_t max_lag, lag_policy policy = lag_policy::drop);
+
+    void detach_sink(size_t sink);
+
+    sink_stats get_sink_stats(size_t sink) const;
+
+    // Number of sinks still attached
+    size_t attached_sinks() const;
+
+    // Delivers everything queued for `sink` into `dst` until the tee is closed and drained,
+    // the sink is detached or `dst` reaches eof. Run each pump as a separate task (e.g. in ParallelAIOs).
+    template <async_writable D>
+    AIO<void> pump(size_t sink, D dst) const {
+        // Everything the pump needs is bound right away, since the Tee may be gone by the time it first runs
+        return run_pump(shared, get_sink(sink), std::move(dst));
+    }
+
+#pragma region IO
+    // Never blocks. Returns eof once no sink is attached anymore.
+    eof<size_t> write_from(std::span<const unsigned char> data);
+
+    // Same as write_from; completes immediately
+    AIO<eof<size_t>> write_async_from(std::span<const unsigned char> data);
+#pragma endregion IO
+
+    // Lets the pumps finish once they have written everything already queued
+    void close();
+};
+
+}  // namespace abel
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Handle.hpp>
+#include <abel/Socket.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <WinSock2.h>
+#include <Windows.h>
+#include <span>
+#include <deque>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+namespace abel {
+
+// A histogram with power-of-two buckets, in microseconds. Coarse, but constant-size and cheap to update.
+struct latency_histogram {
+    static constexpr size_t bucket_count = 40;
+
+    uint64_t buckets[bucket_count]{};
+    uint64_t total = 0;
+
+    void record(aio_clock::duration latency) noexcept;
+
+    // The upper bound of the bucket the percentile falls into, e.g. 0.99 for p99
+    aio_clock::duration percentile(double fraction) const noexcept;
+};
+
+struct write_queue_options {
+    // How long a write may wait for more to coalesce with. Zero flushes on every loop iteration
+    aio_clock::duration flush_delay{};
+    // Flush right away once this much is queued, and don't send more than this at once
+    size_t max_batch_bytes = 256 * 1024;
+    // Backpressure: pushes beyond this are refused until the queue drains
+    size_t max_queued_bytes = 4 * 1024 * 1024;
+    // Buffers per vectored send
+    size_t max_batch_messages = 64;
+};
+
+struct write_queue_stats {
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    // Each is one WSASend
+    uint64_t sends = 0;
+    // Pushes refused due to backpressure
+    uint64_t refused = 0;
+    // From push to the message being fully sent
+    latency_histogram latency{};
+
+    double messages_per_send() const noexcept {
+        return sends ? (double)messages / sends : 0;
+    }
+};
+
+// A per-connection outbound queue. Producers push messages without waiting, and a separate task
+// (run) sends everything that has piled up with a single vectored send, so a burst of tiny writes
+// becomes one system call and, usually, one packet. A flush delay trades latency for larger batches.
+// Not thread-safe: the producers and the sender are meant to be tasks of a single ParallelAIOs.
+class WriteQueue {
+protected:
+    struct message {
+        std::vector<unsigned char> data;
+        aio_clock::time_point queued;
+    };
+
+    Socket socket;
+    write_queue_options options;
+    write_queue_stats stats_{};
+
+    std::deque<message> queue{};
+    // How much of the front message has been sent already
+    size_t front_offset = 0;
+    size_t queued_bytes_ = 0;
+    bool closed = false;
+    bool broken = false;
+
+    OwningHandle has_data = Handle::create_event(true, false);
+    OwningHandle batch_full = Handle::create_event(true, false);
+    OwningHandle has_room = Handle::create_event(true, true);
+
+    // Drops the sent bytes from the queue, recording latencies for completed messages
+    void consume(size_t sent);
+
+public:
+    explicit WriteQueue(Socket socket, write_queue_options options = {});
+
+    WriteQueue(const WriteQueue &other) = delete;
+    WriteQueue &operator=(const WriteQueue &other) = delete;
+
+    // Copies the data into the queue. Returns false, without queueing anything, if that would exceed
+    // max_queued_bytes. A single message larger than that is still accepted into an empty queue.
+    bool push(std::span<const unsigned char> data);
+
+    // Same as push, but waits for room instead of refusing
+    AIO<void> push_async(std::span<const unsigned char> data);
+
+    // Sends whatever gets queued, until the queue is closed and drained, or the connection breaks
+    AIO<void> run();
+
+    // No more pushes are accepted; run completes once everything queued is sent
+    void close();
+
+    constexpr size_t queued_bytes() const noexcept {
+        return queued_bytes_;
+    }
+
+    // The connection broke and the queued data was dropped
+    constexpr bool is_broken() const noexcept {
+        return broken;
+    }
+
+    constexpr const write_queue_stats &stats() const noexcept {
+        return stats_;
+    }
+};
+
+}  // namespace abel
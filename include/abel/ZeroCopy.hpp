@@ -0,0 +1,82 @@
+#pragma once
+
+#include <abel/Error.hpp>
+#include <abel/Socket.hpp>
+#include <abel/IOBase.hpp>
+#include <abel/Concurrency.hpp>
+
+#include <WinSock2.h>
+#include <Windows.h>
+#include <span>
+#include <cstdint>
+
+namespace abel {
+
+struct zero_copy_stats {
+    uint64_t zero_copy_writes = 0;
+    uint64_t zero_copy_bytes = 0;
+    // Writes made before the socket got switched over, which went through the send buffer as usual
+    uint64_t copied_writes = 0;
+    uint64_t copied_bytes = 0;
+};
+
+// A socket adapter that sends large writes straight from the caller's buffer. With the send buffer
+// size set to zero, Winsock doesn't copy overlapped sends into the kernel; it locks the user pages
+// and transmits from them, completing the send only once the stack is done with them, so the
+// buffer may be reused as soon as the AIO completes.
+// The socket is switched over by the first write of at least `threshold` bytes, and is zero-copy only from then on:
+// setting SO_SNDBUF explicitly, even back to its old value, turns off send buffer autotuning for good,
+// so switching back and forth would only cost two system calls per write. Later small writes then wait
+// for their transmission as well, which costs more than the copy it saves, so this is meant for sockets
+// that mostly carry bulk data.
+// The switch is a property of the socket, not of the adapter, so the adapter can't be copied; a socket
+// that already has a zero send buffer (e.g. from another adapter) is picked up as switched on construction.
+class ZeroCopySocket : public IOBase {
+protected:
+    Socket socket_;
+    size_t threshold;
+    // Mirrors the socket's actual SO_SNDBUF being zero
+    bool enabled = false;
+    zero_copy_stats *stats = nullptr;
+
+    void enable();
+
+    bool wants_zero_copy(size_t size) const noexcept {
+        return size >= threshold;
+    }
+
+    void record(size_t size, bool zero_copy) noexcept;
+
+public:
+    // Based on where pinning the pages starts to beat copying them on typical hardware
+    static constexpr size_t default_threshold = 256 * 1024;
+
+    explicit ZeroCopySocket(Socket socket, size_t threshold = default_threshold, zero_copy_stats *stats = nullptr);
+
+    ZeroCopySocket(const ZeroCopySocket &) = delete;
+    ZeroCopySocket &operator=(const ZeroCopySocket &) = delete;
+    ZeroCopySocket(ZeroCopySocket &&) = default;
+    ZeroCopySocket &operator=(ZeroCopySocket &&) = default;
+
+    template <typename Self>
+    constexpr auto &inner(this Self &self) {
+        return self.socket_;
+    }
+
+#pragma region IO
+    eof<size_t> read_into(std::span<unsigned char> data) {
+        return socket_.read_into(data);
+    }
+
+    eof<size_t> write_from(std::span<const unsigned char> data);
+
+    AIO<eof<size_t>> read_async_into(std::span<unsigned char> data) {
+        return socket_.read_async_into(data);
+    }
+
+    // Completes only once the buffer may be reused. Note: the buf must not be located in a coroutine stack.
+    AIO<eof<size_t>> write_async_from(std::span<const unsigned char> data);
+#pragma endregion IO
+};
+
+}  // namespace abel